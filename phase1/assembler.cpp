@@ -0,0 +1,602 @@
+#include<assembler.h>
+#include<encode.h>
+#include<assign.h>
+#include<thread>
+#include<atomic>
+#include<algorithm>
+
+using namespace std;
+
+// Instruction formats:
+// R format: funct7 | rs2 | rs1 | funct3 | rd | opcode
+// I format: imm[11:0] | rs1 | funct3 | rd | opcode
+// etc.
+
+// Lines of .text encoded and formatted per task in the split pass
+const size_t CHUNK_LINES = 4096;
+
+// First line of the text when main is not (see Assembler::assemble())
+const string_view ENTRY_JUMP = "    jal x0, main";
+
+
+static void appendWord(string &out, uint32_t word) {
+    // 32-bit machine word as 0x followed by eight upper-case hex digits
+    static const char digits[] = "0123456789ABCDEF";
+    char hexOutput[10] = {'0', 'x'};
+    for (int i = 9; i >= 2; i--, word >>= 4)
+        hexOutput[i] = digits[word & 0xF];
+    out.append(hexOutput, 10);
+}
+
+static void appendAddress(string &out, LongInt address) {
+    // 0x followed by lower-case hex digits without padding
+    static const char digits[] = "0123456789abcdef";
+    char hexOutput[16];
+    int length = 0;
+    unsigned long long value = address;
+    do {
+        hexOutput[length++] = digits[value & 0xF];
+        value >>= 4;
+    } while (value != 0);
+    out += "0x";
+    while (length > 0)
+        out += hexOutput[--length];
+}
+
+// True if the line only defines a label, which is then stored in label.
+// Needs just the first two tokens.
+static bool labelLine(LineTokens &tokens, string_view &label) {
+    Token token = tokens.tokens[0];
+    bool colon = token.text.back() == ':';
+    if (!colon && (tokens.tokens.size() < 2 || tokens.tokens[1].text != ":")) {
+        return false;
+    }
+    label = token.text;
+    if (colon) label.remove_suffix(1);
+    return true;
+}
+
+void Assembler::formatError(string &errors, const char *what, string_view line, int lineNumber, int column, const string &message) const {
+    errors += what;
+    errors += line;
+    errors += " (" + options.sourceName + ":" + to_string(lineNumber) + ":" + to_string(column) + ": " + message + ")\n";
+}
+
+// Append the output.mc line of an instruction, or its error message
+void Assembler::formatInstruction(string &out, string &errors, const AssembledInstruction &inst) const {
+    if (inst.entry == nullptr) {
+        formatError(errors, "Error in encoding instruction: ", inst.assembly, inst.line, inst.column, inst.error);
+        return;
+    }
+    if (options.listing) {
+        appendAddress(out, inst.address);
+        formatEncoding(out, inst);
+    }
+}
+
+// The part of an output.mc line after the address, which does not depend on it
+static void appendEncoding(string &out, uint32_t word, string_view assembly, const IsaEntry &entry, bool decodedColumn) {
+    out += " , ";
+    appendWord(out, word);
+    out += ' ';
+    out += assembly;
+    if (decodedColumn) {
+        out += " # ";
+        decodeFields(out, entry, word);
+    }
+    out += '\n';
+}
+
+void formatListingLine(string &out, LongInt address, uint32_t word, string_view assembly, const IsaEntry &entry, bool decodedColumn) {
+    appendAddress(out, address);
+    appendEncoding(out, word, assembly, entry, decodedColumn);
+}
+
+void Assembler::formatEncoding(string &out, const AssembledInstruction &inst) const {
+    appendEncoding(out, inst.word, inst.assembly, *inst.entry, options.decodedColumn);
+}
+
+// Encode the instruction whose tokens are in tokens; see process.h for defer
+AssembledInstruction Assembler::encodeInstruction(LineTokens &tokens, string_view instruction, LongInt address, bool defer) {
+    // Operands follow the mnemonic
+    Token token = tokens.tokens[0];
+    tokens.position = 1;
+    // Operand layout and fixed fields come from the shared ISA table
+    AssembledInstruction inst{address, isaFind(token.text.data(), token.text.size()), 0, instruction, tokens.line, token.column, ""};
+    bool encoded = false;
+    if (inst.entry == nullptr) {
+        tokens.fail(token, "unknown instruction '" + string(token.text) + "'");
+    }
+    else {
+        switch (inst.entry->layout) {
+        case OperandLayout::RdRs1Rs2:
+            encoded = processRType(tokens, inst);
+            break;
+        case OperandLayout::RdRs1Imm:
+            encoded = processIType(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::RdMem:
+            encoded = processLoadType(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::Rs2Mem:
+            encoded = processStoreType(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::Rs1Rs2Target:
+            encoded = processBranchType(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::RdUpper:
+            encoded = processUpperImmediate(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::RdTarget:
+            encoded = processJumpType(tokens, inst, symbols, defer);
+            break;
+        case OperandLayout::None:
+            encoded = processSystemType(tokens, inst);
+            break;
+        }
+    }
+    if (!encoded) {
+        inst.entry = nullptr;
+        inst.column = tokens.errorColumn;
+        inst.error = tokens.error;
+    }
+    return inst;
+}
+
+// Encode the instruction in tokens at the program counter
+void Assembler::appendInstruction(LineTokens &tokens, string_view instruction) {
+    assembled.push_back(encodeInstruction(tokens, instruction, instructionPointer, true));
+    const AssembledInstruction &inst = assembled.back();
+    if (inst.pending && inst.entry != nullptr) {
+        textFixups.push_back({assembled.size() - 1, inst.symbol, 0, 0, true});
+    }
+    instructionPointer += 4;
+}
+
+void Assembler::processInstruction(LineTokens &tokens, string_view instruction, string &errors) {
+    // Process each instruction and encode it; label lines define a symbol
+    if (tokens.tokens.empty()) return; // Blank or comment line
+    string_view label;
+    if (labelLine(tokens, label)) {
+        symbols.define(symbols.intern(label), instructionPointer);
+        textLabels.push_back(instructionPointer);
+        return;
+    }
+    if (globalDirective(tokens)) return;
+    PseudoKind kind;
+    if (findPseudo(tokens.tokens[0].text, kind)) {
+        int lineNumber = tokens.line;
+        vector<string_view> expansion;
+        expandPseudoLine(tokens, kind, instruction, expansion, errors);
+        for (string_view line : expansion) {
+            tokens.split(line, lineNumber);
+            appendInstruction(tokens, line);
+        }
+        return;
+    }
+    appendInstruction(tokens, instruction);
+}
+
+// Whether label is at its final address, which la may depend on. Text
+// labels move when the peephole or layout pass changes the text, and
+// every label of an object moves when it is linked.
+bool Assembler::fixedTarget(const Symbol &label) const {
+    return !relocatable && (label.value >= DATA_BASE || !(options.optimize || !options.profile.empty()));
+}
+
+// Base instruction lines of the pseudo-instruction in tokens, kept in
+// rewrittenLines. The la, call and j lines that name a label are the
+// sites of relaxation: each takes the length pseudoLengths holds for it,
+// starting from the shortest that fits the label if it is already
+// defined. A line whose operands are bad gets its error in errors and no
+// instructions.
+void Assembler::expandPseudoLine(LineTokens &tokens, PseudoKind kind, string_view instruction, vector<string_view> &expansion, string &errors) {
+    expansion.clear();
+    PseudoInstruction pseudo;
+    tokens.position = 1;
+    if (!parsePseudo(tokens, kind, pseudo)) {
+        formatError(errors, "Error in encoding instruction: ", instruction, tokens.line, tokens.errorColumn, tokens.error);
+        return;
+    }
+    int length = pseudoLength(pseudo, false, 0, instructionPointer, false);
+    if (!pseudo.label.empty()) {
+        int symbol = symbols.intern(pseudo.label);
+        if (pseudoSites.size() == pseudoLengths.size()) {
+            const Symbol &target = symbols[symbol];
+            pseudoLengths.push_back(target.defined ? pseudoLength(pseudo, true, target.value, instructionPointer, fixedTarget(target)) : 1);
+        }
+        length = pseudoLengths[pseudoSites.size()];
+        pseudoSites.push_back({symbol, instructionPointer, pseudo});
+    }
+
+    vector<string> lines;
+    size_t indent = instruction.find_first_not_of(" \t");
+    expandPseudo(pseudo, length, instruction.substr(0, indent == string_view::npos ? 0 : indent), lines);
+    for (string &line : lines) {
+        rewrittenLines.push_back(move(line));
+        expansion.push_back(rewrittenLines.back());
+    }
+}
+
+// Grow the sites that are too short for where their labels ended up in
+// the last pass; true if the source must be read again
+bool Assembler::relaxPseudo() {
+    bool grown = false;
+    for (size_t i = 0; i < pseudoSites.size(); i++) {
+        const PseudoSite &site = pseudoSites[i];
+        const Symbol &target = symbols[site.symbol];
+        int length = pseudoLength(site.pseudo, target.defined, target.value, site.address, fixedTarget(target));
+        if (length > pseudoLengths[i]) {
+            pseudoLengths[i] = length;
+            grown = true;
+        }
+    }
+    return grown;
+}
+
+// Record the labels of a ".globl name, ..." line, which may stand in
+// either segment; false if the line is something else
+bool Assembler::globalDirective(LineTokens &tokens) {
+    if (tokens.tokens[0].text != ".globl" && tokens.tokens[0].text != ".global") {
+        return false;
+    }
+    for (size_t i = 1; i < tokens.tokens.size(); i++) {
+        globals.push_back(symbols.intern(tokens.tokens[i].text));
+    }
+    return true;
+}
+
+// What the encoding of a label operand depends on: the label's distance
+// from the line, or for %hi and %lo its address
+static LongInt labelOffset(RelocationType type, LongInt value, LongInt address) {
+    return (type == RelocationType::Hi || type == RelocationType::Lo) ? value : value - address;
+}
+
+// Cached encoding of text at address, or nullptr if it must be encoded
+const Assembler::CachedLine *Assembler::cachedEncoding(size_t key, string_view text, LongInt address) const {
+    auto found = encodingCache.find(key);
+    if (found == encodingCache.end() || found->second.text != text) {
+        return nullptr;
+    }
+    const CachedLine &cached = found->second;
+    if (!cached.label.empty()) {
+        int symbol = symbols.find(cached.label);
+        if (symbol < 0 || !symbols[symbol].defined || labelOffset(cached.relocation, symbols[symbol].value, address) != cached.offset) {
+            return nullptr;
+        }
+    }
+    return &cached;
+}
+
+// Cache entry for a line that encoded cleanly
+Assembler::CachedLine Assembler::cacheEntry(string_view text, const AssembledInstruction &inst) const {
+    CachedLine cached{string(text), inst.entry, inst.word, "", inst.relocation, 0, ""};
+    if (options.listing) formatEncoding(cached.formatted, inst);
+    if (inst.symbol >= 0) {
+        cached.label = string(symbols[inst.symbol].name);
+        cached.offset = labelOffset(inst.relocation, symbols[inst.symbol].value, inst.address);
+    }
+    return cached;
+}
+
+// Encode and format lines on options.threads threads. Each task fills the
+// buffers of one chunk, so the output order does not depend on timing.
+// With options.cache lines found in encodingCache are not encoded again;
+// returns how many were.
+size_t Assembler::encodeParallel(const vector<TextLine> &lines, ProgramImage &image, string &errors) {
+    size_t chunkCount = (lines.size() + CHUNK_LINES - 1) / CHUNK_LINES;
+    vector<string> chunks(chunkCount);
+    vector<string> chunkErrors(chunkCount);
+    // New cache entries of each chunk, merged once the workers are done
+    vector<vector<pair<size_t, CachedLine>>> encoded(chunkCount);
+    atomic<size_t> nextChunk(0);
+    atomic<size_t> encodedCount(0);
+    image.text.resize(lines.size());
+
+    auto worker = [&]() {
+        LineTokens tokens;
+        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            size_t first = chunk * CHUNK_LINES;
+            size_t last = min(lines.size(), first + CHUNK_LINES);
+            if (options.listing) chunks[chunk].reserve((last - first) * (options.decodedColumn ? 96 : 48));
+            size_t misses = 0;
+            for (size_t i = first; i < last; i++) {
+                size_t key = options.cache ? hash<string_view>()(lines[i].text) : 0;
+                const CachedLine *cached = options.cache ? cachedEncoding(key, lines[i].text, lines[i].address) : nullptr;
+                if (cached != nullptr) {
+                    image.text[i] = cached->word;
+                    if (options.listing) {
+                        appendAddress(chunks[chunk], lines[i].address);
+                        chunks[chunk] += cached->formatted;
+                    }
+                    continue;
+                }
+                tokens.split(lines[i].text, lines[i].line);
+                AssembledInstruction inst = encodeInstruction(tokens, lines[i].text, lines[i].address, false);
+                misses++;
+                if (options.cache && inst.entry != nullptr) {
+                    encoded[chunk].emplace_back(key, cacheEntry(lines[i].text, inst));
+                }
+                image.text[i] = inst.entry != nullptr ? inst.word : 0;
+                formatInstruction(chunks[chunk], chunkErrors[chunk], inst);
+            }
+            encodedCount += misses;
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < options.threads && t < chunkCount; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (thread &t : workers) {
+        t.join();
+    }
+    for (const string &chunkError : chunkErrors) {
+        errors += chunkError;
+    }
+    if (options.listing) {
+        image.listing = move(chunks);
+    }
+
+    // Start over once entries for lines that are gone dominate the cache
+    if (encodingCache.size() > 2 * lines.size() + CHUNK_LINES) {
+        encodingCache.clear();
+    }
+    for (auto &chunkEntries : encoded) {
+        for (auto &entry : chunkEntries) {
+            encodingCache.insert_or_assign(entry.first, move(entry.second));
+        }
+    }
+    return encodedCount;
+}
+
+// Read source from a clean state, except for encodingCache and
+// pseudoLengths: define its labels and fill the data segment. Without
+// splitPass the text segment is encoded into assembled; with it the
+// instruction lines are left in textLines.
+void Assembler::readPass(string_view source, bool splitPass, vector<TextLine> &textLines, string &errors) {
+    symbols = SymbolTable();
+    instructionPointer = 0;
+    dataSegment = DataSegment();
+    assembled.clear();
+    textFixups.clear();
+    dataFixups.clear();
+    globals.clear();
+    textLabels.clear();
+    rewrittenLines.clear();
+    pseudoSites.clear();
+
+    SourceLines lines(source);
+    string_view instruction;
+    int lineNumber;
+    LineTokens tokens;
+    vector<string_view> expansion;
+
+    if (entryJump) {
+        if (splitPass) {
+            textLines.push_back({ENTRY_JUMP, 0, instructionPointer});
+            instructionPointer += 4;
+        }
+        else {
+            tokens.split(ENTRY_JUMP, 0);
+            appendInstruction(tokens, ENTRY_JUMP);
+        }
+    }
+
+    // Single pass: labels are defined as they are read and forward
+    // references are patched once the whole file is in. With several
+    // threads or the cache this pass only places labels and instruction
+    // lines, which are encoded afterwards.
+    bool inData = false;
+    while (lines.next(instruction, lineNumber)) {
+        if (inData) {
+            if (instruction == ".text") {
+                inData = false;
+                continue;
+            }
+            tokens.split(instruction, lineNumber);
+            if (!tokens.tokens.empty() && globalDirective(tokens)) continue;
+            if (!processDataDirective(tokens, dataSegment, DATA_BASE, symbols, dataFixups)) {
+                formatError(errors, "Error in data directive: ", instruction, lineNumber, tokens.errorColumn, tokens.error);
+            }
+        }
+        else if (instruction == ".data") inData = true;
+        else if (instruction == ".text") continue;
+        else if (!splitPass) {
+            tokens.split(instruction, lineNumber);
+            processInstruction(tokens, instruction, errors);
+        }
+        else {
+            tokens.split(instruction, lineNumber, 2);
+            string_view label;
+            if (tokens.tokens.empty()) continue;
+            if (labelLine(tokens, label)) {
+                symbols.define(symbols.intern(label), instructionPointer);
+                textLabels.push_back(instructionPointer);
+                continue;
+            }
+            if (tokens.tokens[0].text[0] == '.') {
+                tokens.split(instruction, lineNumber);
+                if (globalDirective(tokens)) continue;
+            }
+            PseudoKind kind;
+            if (findPseudo(tokens.tokens[0].text, kind)) {
+                tokens.split(instruction, lineNumber);
+                expandPseudoLine(tokens, kind, instruction, expansion, errors);
+                for (string_view line : expansion) {
+                    textLines.push_back({line, lineNumber, instructionPointer});
+                    instructionPointer += 4;
+                }
+                continue;
+            }
+            textLines.push_back({instruction, lineNumber, instructionPointer});
+            instructionPointer += 4;
+        }
+    }
+}
+
+// Read source, relaxing pseudo-instructions: every site starts at its
+// shortest length, and the source is read again with the sites that
+// turned out too short for their labels grown. Lengths only grow, so the
+// label addresses converge, usually after one or two more passes.
+void Assembler::readSource(string_view source, bool splitPass, vector<TextLine> &textLines, string &errors) {
+    pseudoLengths.clear();
+    string passErrors;
+    do {
+        passErrors.clear();
+        textLines.clear();
+        readPass(source, splitPass, textLines, passErrors);
+    } while (relaxPseudo());
+    errors += passErrors;
+}
+
+ProgramImage Assembler::assemble(string_view source) {
+    ProgramImage image;
+    string errors;
+    bool textMoves = options.optimize || !options.profile.empty();
+    bool splitPass = !textMoves && !options.schedule && (options.threads > 1 || options.cache);
+    vector<TextLine> textLines;
+    relocatable = false;
+    readSource(source, splitPass, textLines, errors);
+    // output.mc has no entry field and runs from address 0, so as in
+    // link() the text starts with a jump to main unless main is first.
+    // The choice of the last run is tried first; a wrong guess reads the
+    // source again.
+    if (entryJump != mainMisplaced()) {
+        entryJump = !entryJump;
+        errors.clear();
+        readSource(source, splitPass, textLines, errors);
+    }
+    if (options.optimize) {
+        image.peephole = optimize();
+    }
+
+    for (const Fixup &fixup : textFixups) {
+        patchInstruction(assembled[fixup.index], symbols[fixup.symbol]);
+    }
+    if (!options.profile.empty()) {
+        image.layout = layoutText(assembled, textLabels, symbols, rewrittenLines, options.profile);
+    }
+    if (options.schedule) {
+        image.schedule = scheduleText(assembled, textLabels, options.forwarding);
+    }
+    for (const Fixup &fixup : dataFixups) {
+        const Symbol &symbol = symbols[fixup.symbol];
+        // Text labels move when the peephole pass deletes instructions or blocks are laid out
+        if (fixup.pending || (textMoves && symbol.defined)) {
+            patchData(dataSegment, fixup, symbol.defined ? symbol.value : fixup.fallback);
+        }
+    }
+
+    // Encode (split pass) and format the text segment
+    if (splitPass) {
+        image.encodedLines = encodeParallel(textLines, image, errors);
+    }
+    else {
+        image.encodedLines = assembled.size();
+        image.text.reserve(assembled.size());
+        image.listing.emplace_back();
+        if (options.listing) image.listing.back().reserve(assembled.size() * (options.decodedColumn ? 96 : 48));
+        for (const AssembledInstruction &inst : assembled) {
+            formatInstruction(image.listing.back(), errors, inst);
+            image.text.push_back(inst.entry != nullptr ? inst.word : 0);
+        }
+    }
+    if (options.listing) {
+        image.listing.emplace_back();
+        image.listing.back().reserve(dataSegment.nextByte() * 3 + 64);
+        dataSegment.format(image.listing.back(), DATA_BASE);
+    }
+    else {
+        image.listing.clear();
+    }
+
+    // Label names point into the source, so the image keeps copies
+    for (int id = 0; id < symbols.size(); id++) {
+        if (symbols[id].defined) image.symbols.emplace_back(string(symbols[id].name), symbols[id].value);
+    }
+    sortSymbols(image.symbols);
+    int mainSymbol = symbols.find("main");
+    image.entry = (mainSymbol >= 0 && symbols[mainSymbol].defined) ? symbols[mainSymbol].value : 0;
+    image.data = move(dataSegment);
+    image.errors = move(errors);
+    return image;
+}
+
+ObjectFile Assembler::assembleObject(string_view source) {
+    ObjectFile object;
+    object.name = options.sourceName;
+    vector<TextLine> textLines;
+    relocatable = true;
+    entryJump = false;
+    readSource(source, false, textLines, object.errors);
+    if (options.optimize) {
+        object.peephole = optimize();
+    }
+    if (!options.profile.empty()) {
+        object.layout = layoutText(assembled, textLabels, symbols, rewrittenLines, options.profile);
+    }
+    if (options.schedule) {
+        object.schedule = scheduleText(assembled, textLabels, options.forwarding);
+    }
+
+    // Every label reference is relocated, even one to a label of this
+    // file: text and data move independently when objects are linked
+    object.text.reserve(assembled.size());
+    for (const AssembledInstruction &inst : assembled) {
+        if (inst.entry == nullptr) {
+            formatError(object.errors, "Error in encoding instruction: ", inst.assembly, inst.line, inst.column, inst.error);
+            object.text.push_back({0, nullptr, string(inst.assembly), inst.line});
+            continue;
+        }
+        object.text.push_back({inst.word, inst.entry, string(inst.assembly), inst.line});
+        if (inst.symbol >= 0) {
+            object.relocations.push_back({inst.relocation, inst.address, string(symbols[inst.symbol].name), 0, 0, inst.column});
+        }
+    }
+    for (const Fixup &fixup : dataFixups) {
+        object.relocations.push_back({RelocationType::Data, static_cast<LongInt>(fixup.index), string(symbols[fixup.symbol].name), fixup.size, fixup.fallback, 0});
+    }
+
+    vector<bool> global(symbols.size());
+    for (int id : globals) {
+        global[id] = true;
+    }
+    for (int id = 0; id < symbols.size(); id++) {
+        if (symbols[id].defined) object.symbols.push_back({string(symbols[id].name), symbols[id].value, global[id]});
+    }
+    object.data = move(dataSegment);
+    return object;
+}
+
+// Whether main is a text label other than the first instruction of the
+// source, which needs the jump in front of it
+bool Assembler::mainMisplaced() const {
+    int mainSymbol = symbols.find("main");
+    if (mainSymbol < 0 || !symbols[mainSymbol].defined) return false;
+    LongInt main = symbols[mainSymbol].value;
+    return main < DATA_BASE && main != (entryJump ? 4 : 0);
+}
+
+// Run the peephole pass over the single-pass text; the fixups of labels
+// that are still undefined point at the compacted text afterwards
+PeepholeReport Assembler::optimize() {
+    PeepholeReport report = optimizeText(assembled, textLabels, symbols, rewrittenLines);
+    textFixups.clear();
+    for (size_t i = 0; i < assembled.size(); i++) {
+        const AssembledInstruction &inst = assembled[i];
+        if (inst.pending && inst.entry != nullptr) textFixups.push_back({i, inst.symbol, 0, 0, true});
+    }
+    return report;
+}
+
+void sortSymbols(vector<pair<string, LongInt>> &symbols) {
+    sort(symbols.begin(), symbols.end(), [](const pair<string, LongInt> &a, const pair<string, LongInt> &b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+}
+
+ProgramImage assemble(string_view source, const AssemblerOptions &options) {
+    return Assembler(options).assemble(source);
+}
@@ -0,0 +1,171 @@
+#include<string>
+#include<string_view>
+#include<vector>
+#include<unordered_map>
+#include<deque>
+#include<cstdint>
+#include<process.h>
+#include<scheduler.h>
+#include<peephole.h>
+#include<layout.h>
+#include<pseudo.h>
+
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+using namespace std;
+
+// Address of the first byte of the data segment
+const LongInt DATA_BASE = 1LL << 28;
+
+struct AssemblerOptions {
+    string sourceName = "input.asm"; // Used in error messages
+    unsigned threads = 1;            // Threads encoding .text; 1 keeps the single pass
+    bool listing = false;            // Format the output.mc text
+    bool decodedColumn = true;       // Include "# <decoded fields>" in the listing
+    bool cache = false;              // Reuse encodings from the previous assemble()
+    bool optimize = false;           // Peephole pass; implies one pass, no cache
+    bool schedule = false;           // Reorder instructions to avoid stalls; implies one pass, no cache
+    bool forwarding = true;          // Hazard rules of the pipeline the schedule targets
+    BranchProfile profile;           // rvsim --profile of this file; non-empty: lay out blocks by it
+};
+
+// Everything assembled from one source. It owns its data, so the source
+// may go away.
+struct ProgramImage {
+    vector<uint32_t> text;                  // One word per instruction from address 0, 0 where a line failed
+    DataSegment data;                       // Loaded at DATA_BASE
+    vector<pair<string, LongInt>> symbols;  // Defined labels by address, then name
+    LongInt entry = 0;                      // main if it is defined
+    string errors;                          // One message per line, as the assembler prints them
+    vector<string> listing;                 // output.mc in pieces, with options.listing
+    size_t encodedLines = 0;                // Instructions encoded rather than found in the cache
+    PeepholeReport peephole;                // With options.optimize
+    LayoutReport layout;                    // With options.profile
+    ScheduleReport schedule;                // With options.schedule
+
+    bool ok() const { return errors.empty(); }
+};
+
+// Label reference of an object, resolved by link()
+struct Relocation {
+    RelocationType type;
+    LongInt offset;     // Text: byte offset of the instruction. Data: DataSegment::nextByte() of the value
+    string symbol;
+    int size;           // Data bytes to patch
+    LongInt fallback;   // Data value kept if no object defines the label
+    int column;         // Of the label operand in the instruction's line
+};
+
+struct ObjectSymbol {
+    string name;
+    LongInt value;      // Offset into the text, or DATA_BASE plus the offset into the data
+    bool global;        // Named by .globl, so other objects see it
+};
+
+// Line of an object's text
+struct ObjectInstruction {
+    uint32_t word;          // 0 where the line failed
+    const IsaEntry *entry;  // nullptr where the line failed
+    string assembly;        // Source line, for the listing and link errors
+    int line;
+};
+
+// One source assembled on its own, text from 0 and data from DATA_BASE.
+// Every label reference is left as a relocation for link(), so objects do
+// not depend on each other and can be assembled in any order.
+struct ObjectFile {
+    string name;                    // options.sourceName
+    vector<ObjectInstruction> text;
+    DataSegment data;
+    vector<ObjectSymbol> symbols;   // Defined labels
+    vector<Relocation> relocations;
+    string errors;
+    PeepholeReport peephole;        // With options.optimize
+    LayoutReport layout;            // With options.profile
+    ScheduleReport schedule;        // With options.schedule
+
+    bool ok() const { return errors.empty(); }
+};
+
+// Assembler state. An object assembles one source at a time, and separate
+// objects may be used on separate threads. With options.cache it keeps the
+// encodings of each source for the next assemble().
+class Assembler {
+public:
+    explicit Assembler(const AssemblerOptions &options = AssemblerOptions()) : options(options) {}
+    ProgramImage assemble(string_view source);
+    // Assemble source for link(), in one pass whatever the options
+    ObjectFile assembleObject(string_view source);
+
+private:
+    // Instruction line waiting to be encoded after the split pass
+    struct TextLine {
+        string_view text;
+        int line;
+        LongInt address;
+    };
+
+    // Encoding of a source line from an earlier run. Lines are keyed by
+    // the hash of their text; a branch or jal is reused only while its
+    // label sits at the same distance from it.
+    struct CachedLine {
+        string text;
+        const IsaEntry *entry;
+        uint32_t word;
+        string label;       // Label operand, empty if the line names none
+        RelocationType relocation;
+        LongInt offset;     // Label address when encoded, minus the line address unless %hi or %lo
+        string formatted;   // formatEncoding() of the line
+    };
+
+    // Pseudo-instruction whose length depends on where its label is
+    struct PseudoSite {
+        int symbol;
+        LongInt address;
+        PseudoInstruction pseudo;
+    };
+
+    AssemblerOptions options;
+    SymbolTable symbols;                    // Text and data labels
+    LongInt instructionPointer = 0;         // Program counter
+    DataSegment dataSegment;                // Grows with each data directive
+    vector<AssembledInstruction> assembled; // Encoded text segment, one entry per instruction line
+    vector<Fixup> textFixups, dataFixups;   // Forward label references; every label in data
+    vector<int> globals;                    // Labels named by .globl
+    vector<LongInt> textLabels;             // Address of each text label definition, in order
+    deque<string> rewrittenLines;           // Assembly text of expanded pseudo-instructions and of lines the peephole and layout passes replaced
+    bool relocatable = false;               // Assembling an object, whose addresses change when it is linked
+    bool entryJump = false;                 // The text starts with a jal x0, main
+    vector<PseudoSite> pseudoSites;         // Label-dependent pseudo-instructions of the last pass over the source
+    vector<int> pseudoLengths;              // Instructions given to each of them, in source order
+    unordered_map<size_t, CachedLine> encodingCache;
+
+    void formatInstruction(string &out, string &errors, const AssembledInstruction &inst) const;
+    void formatEncoding(string &out, const AssembledInstruction &inst) const;
+    void formatError(string &errors, const char *what, string_view line, int lineNumber, int column, const string &message) const;
+    AssembledInstruction encodeInstruction(LineTokens &tokens, string_view instruction, LongInt address, bool defer);
+    void appendInstruction(LineTokens &tokens, string_view instruction);
+    void processInstruction(LineTokens &tokens, string_view instruction, string &errors);
+    bool fixedTarget(const Symbol &label) const;
+    void expandPseudoLine(LineTokens &tokens, PseudoKind kind, string_view instruction, vector<string_view> &expansion, string &errors);
+    bool relaxPseudo();
+    bool globalDirective(LineTokens &tokens);
+    void readPass(string_view source, bool splitPass, vector<TextLine> &textLines, string &errors);
+    void readSource(string_view source, bool splitPass, vector<TextLine> &textLines, string &errors);
+    PeepholeReport optimize();
+    bool mainMisplaced() const;
+    const CachedLine *cachedEncoding(size_t key, string_view text, LongInt address) const;
+    CachedLine cacheEntry(string_view text, const AssembledInstruction &inst) const;
+    size_t encodeParallel(const vector<TextLine> &lines, ProgramImage &image, string &errors);
+};
+
+// Assemble source in one go with the given options
+ProgramImage assemble(string_view source, const AssemblerOptions &options = AssemblerOptions());
+
+// Order labels by address, then name
+void sortSymbols(vector<pair<string, LongInt>> &symbols);
+
+// Append the output.mc line of an encoded instruction
+void formatListingLine(string &out, LongInt address, uint32_t word, string_view assembly, const IsaEntry &entry, bool decodedColumn);
+
+#endif
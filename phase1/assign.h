@@ -1,6 +1,7 @@
 #include <iostream>
 #include<string>
 #include<bits/stdc++.h>
+#include "../phase3/isa.h"
 
 using namespace std;  
 
@@ -11,11 +12,7 @@ using namespace std;
 #endif
 
 
-long long parseValue(string valueStr);
-string determineOpcode (string mnemonic, string binaryStr);
-string determineFunct3 (string mnemonic, string binaryStr);
-string determineFunct7 (string mnemonic, string binaryStr);
-string encodeImmediate(string valueStr, string binaryStr);
-string encodeBranchImmediate(string valueStr, string binaryStr);
-string encodeUpperImmediate(string valueStr, string binaryStr);
-
+long long parseValue(string_view valueStr);
+bool encodeImmediate(string_view valueStr, int32_t &imm);
+bool encodeBranchImmediate(long long offset, int32_t &imm);
+bool encodeUpperImmediate(string_view valueStr, int32_t &imm);
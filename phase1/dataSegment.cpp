@@ -0,0 +1,118 @@
+#include<dataSegment.h>
+#include<algorithm>
+#include<cstdio>
+#include<cstring>
+
+using namespace std;
+
+// Stored bytes per output row
+const int ROW_BYTES = 16;
+
+void DataSegment::store(LongInt value, int size) {
+    if (runs.empty() || runs.back().fill >= 0) {
+        runs.push_back({length, 0, bytes.size(), -1});
+    }
+    for (int byteIndex = 0; byteIndex < size; byteIndex++) {
+        bytes.push_back(value & 0xFF);
+        value >>= 8;
+    }
+    runs.back().length += size;
+    length += size;
+}
+
+void DataSegment::patch(size_t index, LongInt value, int size) {
+    for (int byteIndex = 0; byteIndex < size; byteIndex++) {
+        bytes[index + byteIndex] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+void DataSegment::fill(LongInt count, uint8_t fill) {
+    if (count <= 0) return;
+    if (runs.empty() || runs.back().fill != fill) {
+        runs.push_back({length, 0, 0, fill});
+    }
+    runs.back().length += count;
+    length += count;
+}
+
+void DataSegment::align(LongInt base, LongInt boundary) {
+    largestBoundary = max(largestBoundary, boundary);
+    LongInt misalignment = (base + length) % boundary;
+    if (misalignment != 0) {
+        fill(boundary - misalignment, 0);
+    }
+}
+
+void DataSegment::append(const DataSegment &other) {
+    for (const Run &run : other.runs) {
+        if (run.fill >= 0) {
+            fill(run.length, run.fill);
+            continue;
+        }
+        if (runs.empty() || runs.back().fill >= 0) {
+            runs.push_back({length, 0, bytes.size(), -1});
+        }
+        bytes.insert(bytes.end(), other.bytes.begin() + run.first, other.bytes.begin() + run.first + run.length);
+        runs.back().length += run.length;
+        length += run.length;
+    }
+    largestBoundary = max(largestBoundary, other.largestBoundary);
+}
+
+LongInt DataSegment::zeroTail() const {
+    LongInt tail = 0;
+    for (auto run = runs.rbegin(); run != runs.rend() && run->fill == 0; ++run) {
+        tail += run->length;
+    }
+    return tail;
+}
+
+void DataSegment::flatten(uint8_t *out, LongInt count) const {
+    for (const Run &run : runs) {
+        if (run.offset >= count) break;
+        LongInt length = min(run.length, count - run.offset);
+        if (run.fill >= 0) memset(out + run.offset, run.fill, length);
+        else memcpy(out + run.offset, &bytes[run.first], length);
+    }
+}
+
+static void appendHexByte(string &out, uint8_t value) {
+    static const char digits[] = "0123456789ABCDEF";
+    out += digits[value >> 4];
+    out += digits[value & 0xF];
+}
+
+static void appendAddress(string &out, LongInt address) {
+    char hexOutput[24];
+    int count = snprintf(hexOutput, sizeof(hexOutput), "0x%llx   ", address);
+    out.append(hexOutput, count);
+}
+
+// Stored bytes go out ROW_BYTES to a row ("0x10000000   01 00 00 00 ");
+// a filled range is one row holding the byte and a hex count
+// ("0x10000040   00*1000" is 4096 zero bytes).
+void DataSegment::format(string &out, LongInt base) const {
+    out += "\n\n";
+    out += "***********************************************************************************************\n";
+    out += "Data Segment\n";
+
+    for (const Run &run : runs) {
+        if (run.fill >= 0) {
+            char count[24];
+            appendAddress(out, base + run.offset);
+            appendHexByte(out, run.fill);
+            out.append(count, snprintf(count, sizeof(count), "*%llx\n", run.length));
+            continue;
+        }
+        for (LongInt row = 0; row < run.length; row += ROW_BYTES) {
+            appendAddress(out, base + run.offset + row);
+            LongInt rowEnd = min<LongInt>(run.length, row + ROW_BYTES);
+            for (LongInt i = row; i < rowEnd; i++) {
+                appendHexByte(out, bytes[run.first + i]);
+                out += ' ';
+            }
+            out += '\n';
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#include<string>
+#include<vector>
+#include<cstdint>
+
+#ifndef DATASEGMENT_H
+#define DATASEGMENT_H
+typedef long long LongInt;
+using namespace std;
+
+// Contents of the data segment, grown as directives are read. Bytes stored
+// by .byte, .word and the like are kept; .space, .zero and .align padding
+// only record a range and its fill byte.
+class DataSegment {
+public:
+    LongInt size() const { return length; }
+
+    // Index of the next stored byte, for patch()
+    size_t nextByte() const { return bytes.size(); }
+
+    // Append size bytes of value, little-endian
+    void store(LongInt value, int size);
+    // Overwrite size bytes from the stored byte at index
+    void patch(size_t index, LongInt value, int size);
+    // Append count copies of fill
+    void fill(LongInt count, uint8_t fill);
+    // Pad with zeros up to a multiple of boundary, counted from base
+    void align(LongInt base, LongInt boundary);
+    // Largest boundary passed to align() so far, at least 1
+    LongInt alignment() const { return largestBoundary; }
+    // Append all of other; its stored byte i becomes nextByte() + i
+    void append(const DataSegment &other);
+
+    // Length of the zero fill at the end of the segment
+    LongInt zeroTail() const;
+    // Copy the first count bytes of the segment, fills included, to out
+    void flatten(uint8_t *out, LongInt count) const;
+
+    // Visit the segment in order: store(offset, bytes, length) for stored
+    // bytes and fill(offset, value, length) for filled ranges
+    template <typename Store, typename Fill>
+    void forEachRun(Store store, Fill fill) const {
+        for (const Run &run : runs) {
+            if (run.fill >= 0) fill(run.offset, static_cast<uint8_t>(run.fill), run.length);
+            else store(run.offset, &bytes[run.first], run.length);
+        }
+    }
+
+    // Append the "Data Segment" rows of output.mc for the segment at base
+    void format(string &out, LongInt base) const;
+
+private:
+    // Consecutive bytes that are either stored or all equal to fill
+    struct Run {
+        LongInt offset;
+        LongInt length;
+        size_t first;   // Index into bytes of a stored run
+        int fill;       // Fill byte, or -1 for stored bytes
+    };
+
+    vector<uint8_t> bytes;
+    vector<Run> runs;
+    LongInt length = 0;
+    LongInt largestBoundary = 1;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include<elfWriter.h>
+#include<elf.h>
+#include<cstring>
+
+using namespace std;
+
+// Loadable segments start on page boundaries in the file
+const uint32_t PAGE_SIZE = 0x1000;
+
+// Section header indexes
+enum Section { NO_SECTION, TEXT, DATA, BSS, SYMTAB, STRTAB, SHSTRTAB, SECTION_COUNT };
+
+static uint32_t alignUp(uint32_t value, uint32_t boundary) {
+    return (value + boundary - 1) & ~(boundary - 1);
+}
+
+// Append name and its terminator to a string table; returns its offset
+static uint32_t addName(string &table, string_view name) {
+    uint32_t offset = table.size();
+    table.append(name.data(), name.size());
+    table += '\0';
+    return offset;
+}
+
+template <typename T>
+static void put(string &image, uint32_t offset, const T &value) {
+    memcpy(&image[offset], &value, sizeof(T));
+}
+
+string elfImage(const ProgramImage &program) {
+    const vector<uint32_t> &text = program.text;
+    const DataSegment &data = program.data;
+    uint32_t textSize = text.size() * 4;
+    uint32_t bssSize = data.zeroTail();
+    uint32_t dataSize = data.size() - bssSize;
+    uint32_t dataAddress = DATA_BASE;
+
+    // Section names
+    string sectionNames(1, '\0');
+    uint32_t nameOffsets[SECTION_COUNT] = {0};
+    const char *names[SECTION_COUNT] = {"", ".text", ".data", ".bss", ".symtab", ".strtab", ".shstrtab"};
+    for (int i = TEXT; i < SECTION_COUNT; i++) {
+        nameOffsets[i] = addName(sectionNames, names[i]);
+    }
+
+    // Symbols: the null entry, then every label in address order
+    string symbolNames(1, '\0');
+    vector<Elf32_Sym> symbolEntries(1, Elf32_Sym{});
+    for (const auto &symbol : program.symbols) {
+        Elf32_Sym entry{};
+        entry.st_name = addName(symbolNames, symbol.first);
+        entry.st_value = symbol.second;
+        bool inData = symbol.second >= DATA_BASE;
+        entry.st_info = ELF32_ST_INFO(STB_GLOBAL, inData ? STT_OBJECT : STT_NOTYPE);
+        if (!inData) entry.st_shndx = TEXT;
+        else if (bssSize > 0 && symbol.second >= DATA_BASE + dataSize) entry.st_shndx = BSS;
+        else entry.st_shndx = DATA;
+        symbolEntries.push_back(entry);
+    }
+
+    // File layout: headers, then .text and .data on their own pages, then
+    // the tables and the section headers
+    int segmentCount = (textSize > 0) + (dataSize + bssSize > 0);
+    uint32_t textOffset = PAGE_SIZE;
+    uint32_t dataOffset = alignUp(textOffset + textSize, PAGE_SIZE);
+    uint32_t symtabOffset = alignUp(dataOffset + dataSize, 4);
+    uint32_t symtabSize = symbolEntries.size() * sizeof(Elf32_Sym);
+    uint32_t strtabOffset = symtabOffset + symtabSize;
+    uint32_t shstrtabOffset = strtabOffset + symbolNames.size();
+    uint32_t sectionHeaderOffset = alignUp(shstrtabOffset + sectionNames.size(), 4);
+    string image(sectionHeaderOffset + SECTION_COUNT * sizeof(Elf32_Shdr), '\0');
+
+    Elf32_Ehdr header{};
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS32;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_RISCV;
+    header.e_version = EV_CURRENT;
+    header.e_entry = program.entry;
+    header.e_phoff = sizeof(Elf32_Ehdr);
+    header.e_shoff = sectionHeaderOffset;
+    header.e_ehsize = sizeof(Elf32_Ehdr);
+    header.e_phentsize = sizeof(Elf32_Phdr);
+    header.e_phnum = segmentCount;
+    header.e_shentsize = sizeof(Elf32_Shdr);
+    header.e_shnum = SECTION_COUNT;
+    header.e_shstrndx = SHSTRTAB;
+    put(image, 0, header);
+
+    // Program headers
+    uint32_t programHeader = sizeof(Elf32_Ehdr);
+    if (textSize > 0) {
+        Elf32_Phdr segment{PT_LOAD, textOffset, 0, 0, textSize, textSize, PF_R | PF_X, PAGE_SIZE};
+        put(image, programHeader, segment);
+        programHeader += sizeof(Elf32_Phdr);
+    }
+    if (dataSize + bssSize > 0) {
+        Elf32_Phdr segment{PT_LOAD, dataOffset, dataAddress, dataAddress, dataSize, dataSize + bssSize, PF_R | PF_W, PAGE_SIZE};
+        put(image, programHeader, segment);
+    }
+
+    // Contents
+    for (size_t i = 0; i < text.size(); i++) {
+        put(image, textOffset + 4 * i, text[i]);
+    }
+    data.flatten(reinterpret_cast<uint8_t *>(&image[dataOffset]), dataSize);
+    for (size_t i = 0; i < symbolEntries.size(); i++) {
+        put(image, symtabOffset + i * sizeof(Elf32_Sym), symbolEntries[i]);
+    }
+    memcpy(&image[strtabOffset], symbolNames.data(), symbolNames.size());
+    memcpy(&image[shstrtabOffset], sectionNames.data(), sectionNames.size());
+
+    // Section headers
+    Elf32_Shdr sections[SECTION_COUNT] = {};
+    sections[TEXT] = {nameOffsets[TEXT], SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 0, textOffset, textSize, 0, 0, 4, 0};
+    sections[DATA] = {nameOffsets[DATA], SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, dataAddress, dataOffset, dataSize, 0, 0, 1, 0};
+    sections[BSS] = {nameOffsets[BSS], SHT_NOBITS, SHF_ALLOC | SHF_WRITE, dataAddress + dataSize, dataOffset + dataSize, bssSize, 0, 0, 1, 0};
+    sections[SYMTAB] = {nameOffsets[SYMTAB], SHT_SYMTAB, 0, 0, symtabOffset, symtabSize, STRTAB, 1, 4, sizeof(Elf32_Sym)};
+    sections[STRTAB] = {nameOffsets[STRTAB], SHT_STRTAB, 0, 0, strtabOffset, static_cast<uint32_t>(symbolNames.size()), 0, 0, 1, 0};
+    sections[SHSTRTAB] = {nameOffsets[SHSTRTAB], SHT_STRTAB, 0, 0, shstrtabOffset, static_cast<uint32_t>(sectionNames.size()), 0, 0, 1, 0};
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        put(image, sectionHeaderOffset + i * sizeof(Elf32_Shdr), sections[i]);
+    }
+    return image;
+}
@@ -0,0 +1,16 @@
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<assembler.h>
+
+#ifndef ELFWRITER_H
+#define ELFWRITER_H
+using namespace std;
+
+// Little-endian ELF32 RISC-V executable of an assembled program. The
+// words go into .text at address 0 and the data segment into .data at
+// DATA_BASE, except for its trailing zero fill, which becomes .bss. Every
+// label is listed in .symtab, and the entry point is program.entry.
+string elfImage(const ProgramImage &program);
+
+#endif
@@ -1,7 +1,7 @@
 #include<iostream>
 #include<string>
-#include<unordered_map>
 #include<bits/stdc++.h>
+#include "../phase3/isa.h"
 
 #ifndef ENCODE_H
 #define ENCODE_H
@@ -9,5 +9,4 @@ using namespace std;
 
 #endif
 
-void setupRegisterMapping (unordered_map<string, string> &registerMap);
-string encodeRegister(string reg, string binaryStr, unordered_map<string, string> &registerMap);
\ No newline at end of file
+int encodeRegister(string_view reg);
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include<layout.h>
+#include<fstream>
+#include<sstream>
+#include<algorithm>
+
+using namespace std;
+
+bool readBranchProfile(const string &path, BranchProfile &profile, string &error) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot read " + path;
+        return false;
+    }
+    string line;
+    for (int number = 1; getline(file, line); number++) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#') continue;
+        istringstream fields(line);
+        string pc;
+        BranchCount count;
+        fields >> pc >> count.taken >> count.notTaken;
+        char *end = nullptr;
+        LongInt address = strtoll(pc.c_str(), &end, 0);
+        if (!fields || pc.empty() || *end != '\0') {
+            error = path + ":" + to_string(number) + ": expected 'pc taken not-taken'";
+            return false;
+        }
+        BranchCount &total = profile[address];
+        total.taken += count.taken;
+        total.notTaken += count.notTaken;
+    }
+    return true;
+}
+
+namespace {
+
+// How a block hands over to the block after it in the source
+enum class Exit {
+    Branch,     // Conditional branch with both successors in the text
+    Jump,       // jal x0, jalr x0, or beq/bge of a register with itself: no fall-through
+    Falls       // Everything else, including calls and unknown targets
+};
+
+struct Block {
+    size_t first;           // Index of the first instruction
+    size_t end;             // One past the last instruction
+    Exit exit;
+    size_t target;          // Taken successor (Exit::Branch)
+    BranchCount count;      // Profile of the branch (Exit::Branch)
+};
+
+}
+
+// Text address of a branch or jal target, or -1 if it is not known here
+static LongInt targetOf(const AssembledInstruction &inst, const SymbolTable &symbols) {
+    if (inst.symbol < 0) return inst.address + isaImmediate(inst.entry->type, inst.word);
+    return symbols[inst.symbol].defined ? symbols[inst.symbol].value : -1;
+}
+
+static const char *invertedName(Mnemonic id) {
+    switch (id) {
+    case Mnemonic::BEQ: return "bne";
+    case Mnemonic::BNE: return "beq";
+    case Mnemonic::BLT: return "bge";
+    case Mnemonic::BGE: return "blt";
+    case Mnemonic::BLTU: return "bgeu";
+    case Mnemonic::BGEU: return "bltu";
+    default: return nullptr;
+    }
+}
+
+// Label at address for the listing, or the offset from the instruction
+static string targetText(const SymbolTable &symbols, LongInt address, LongInt offset, LongInt textEnd) {
+    for (int id = 0; id < symbols.size(); id++) {
+        if (symbols[id].defined && symbols[id].value == address && address <= textEnd) return string(symbols[id].name);
+    }
+    return to_string(offset);
+}
+
+// Assembly text for an added or inverted control instruction, indented like model
+static string_view controlLine(deque<string> &lines, string_view model, const string &operands) {
+    size_t indent = model.find_first_not_of(" \t");
+    lines.push_back(string(model.substr(0, indent == string_view::npos ? 0 : indent)) + operands);
+    return lines.back();
+}
+
+LayoutReport layoutText(vector<AssembledInstruction> &text, vector<LongInt> &textLabels, SymbolTable &symbols, deque<string> &lines, const BranchProfile &profile) {
+    LayoutReport report;
+    size_t n = text.size();
+    LongInt textEnd = static_cast<LongInt>(n) * 4;
+    for (const AssembledInstruction &inst : text) {
+        if (inst.entry == nullptr) return report;
+    }
+    auto indexOf = [&](LongInt address) {
+        return (address >= 0 && address % 4 == 0 && address < textEnd) ? static_cast<size_t>(address / 4) : SIZE_MAX;
+    };
+
+    // Basic blocks, as in the scheduler and the peephole pass
+    vector<bool> startsBlock(n + 1, false);
+    startsBlock[0] = true;
+    for (LongInt label : textLabels) {
+        if (indexOf(label) != SIZE_MAX) startsBlock[label / 4] = true;
+    }
+    for (size_t i = 0; i < n; i++) {
+        InstType type = text[i].entry->type;
+        if (type != InstType::SB && type != InstType::JAL && type != InstType::JALR) continue;
+        startsBlock[i + 1] = true;
+        if (type != InstType::JALR) {
+            size_t target = indexOf(targetOf(text[i], symbols));
+            if (target != SIZE_MAX) startsBlock[target] = true;
+        }
+    }
+    vector<Block> blocks;
+    vector<size_t> blockAt(n, SIZE_MAX);
+    for (size_t i = 0; i < n; i++) {
+        if (startsBlock[i]) {
+            blockAt[i] = blocks.size();
+            blocks.push_back({i, i, Exit::Falls, 0, {}});
+        }
+        blocks.back().end = i + 1;
+    }
+    if (blocks.size() < 2) return report;
+
+    size_t matched = 0;
+    for (const AssembledInstruction &inst : text) {
+        if (inst.entry->type == InstType::SB && profile.count(inst.address)) matched++;
+    }
+    report.stale = profile.size() - matched;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        const AssembledInstruction &last = text[blocks[b].end - 1];
+        InstType type = last.entry->type;
+        bool link = rdField(last.word) != 0;
+        // A register always equals itself, so these branches always or never go
+        bool selfCompare = type == InstType::SB && rs1Field(last.word) == rs2Field(last.word);
+        Mnemonic id = last.entry->id;
+        if (((type == InstType::JAL || type == InstType::JALR) && !link) || (selfCompare && (id == Mnemonic::BEQ || id == Mnemonic::BGE || id == Mnemonic::BGEU))) {
+            blocks[b].exit = Exit::Jump;
+        }
+        else if (type == InstType::SB && !selfCompare && b + 1 < blocks.size() && invertedName(id) != nullptr) {
+            size_t target = indexOf(targetOf(last, symbols));
+            if (target == SIZE_MAX) continue;
+            blocks[b].exit = Exit::Branch;
+            blocks[b].target = blockAt[target];
+            auto found = profile.find(last.address);
+            if (found != profile.end()) {
+                blocks[b].count = found->second;
+                report.takenBefore += found->second.taken;
+            }
+        }
+    }
+
+    // Chains of blocks that must or should be laid out back to back
+    vector<vector<size_t>> chains;
+    vector<size_t> chainOf(blocks.size());
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (b == 0 || blocks[b - 1].exit != Exit::Falls) chains.emplace_back();
+        chains.back().push_back(b);
+        chainOf[b] = chains.size() - 1;
+    }
+    size_t entryChain = chainOf[0];
+    size_t endChain = blocks.back().exit == Exit::Falls ? chainOf[blocks.size() - 1] : SIZE_MAX;
+
+    struct Edge {
+        uint64_t weight;
+        size_t from;
+        size_t to;
+    };
+    vector<Edge> edges;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        if (blocks[b].exit != Exit::Branch) continue;
+        if (blocks[b].count.taken > 0) edges.push_back({blocks[b].count.taken, b, blocks[b].target});
+        if (blocks[b].count.notTaken > 0) edges.push_back({blocks[b].count.notTaken, b, b + 1});
+    }
+    stable_sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) { return a.weight > b.weight; });
+    for (const Edge &edge : edges) {
+        size_t from = chainOf[edge.from], to = chainOf[edge.to];
+        if (from == to || to == entryChain || from == endChain || (from == entryChain && to == endChain)) continue;
+        if (chains[from].back() != edge.from || chains[to].front() != edge.to) continue;
+        for (size_t b : chains[to]) {
+            chainOf[b] = from;
+        }
+        chains[from].insert(chains[from].end(), chains[to].begin(), chains[to].end());
+        chains[to].clear();
+        if (to == endChain) endChain = from;
+    }
+
+    // Entry chain first, the chain that runs off the end last, the rest in source order
+    vector<size_t> order(chains[entryChain]);
+    for (size_t c = 0; c < chains.size(); c++) {
+        if (c != entryChain && c != endChain) order.insert(order.end(), chains[c].begin(), chains[c].end());
+    }
+    if (endChain != SIZE_MAX && endChain != entryChain) order.insert(order.end(), chains[endChain].begin(), chains[endChain].end());
+    bool changed = false;
+    for (size_t k = 0; k < order.size(); k++) {
+        if (order[k] != k) changed = true;
+    }
+    if (!changed) {
+        report.takenAfter = report.takenBefore;
+        return report;
+    }
+
+    // New address of every old instruction, and what each branch becomes
+    enum class Fix { None, Invert, AddJump };
+    vector<Fix> fix(blocks.size(), Fix::None);
+    vector<LongInt> moved(n + 1);
+    LongInt next = 0;
+    for (size_t k = 0; k < order.size(); k++) {
+        size_t b = order[k];
+        size_t follower = k + 1 < order.size() ? order[k + 1] : SIZE_MAX;
+        if (blocks[b].exit == Exit::Branch && follower != b + 1) {
+            fix[b] = follower == blocks[b].target ? Fix::Invert : Fix::AddJump;
+        }
+        for (size_t i = blocks[b].first; i < blocks[b].end; i++) {
+            moved[i] = next;
+            next += 4;
+        }
+        if (fix[b] == Fix::AddJump) next += 4;
+        const BranchCount &count = blocks[b].count;
+        report.takenAfter += fix[b] == Fix::None ? count.taken : fix[b] == Fix::Invert ? count.notTaken : count.taken + count.notTaken;
+        if (order[k] != k) report.moved++;
+    }
+    moved[n] = next;
+    auto relocated = [&](LongInt address) {
+        return (address >= 0 && address % 4 == 0 && address <= textEnd) ? moved[address / 4] : address;
+    };
+
+    // Build the new text aside, so a branch that no longer reaches leaves text as it was
+    vector<AssembledInstruction> laid;
+    laid.reserve(moved[n] / 4);
+    for (size_t b : order) {
+        for (size_t i = blocks[b].first; i < blocks[b].end; i++) {
+            AssembledInstruction inst = text[i];
+            inst.address = moved[i];
+            InstType type = inst.entry->type;
+            bool control = type == InstType::SB || type == InstType::JAL;
+            const char *problem = nullptr;
+            if (i + 1 == blocks[b].end && fix[b] == Fix::Invert) {
+                LongInt fallThrough = relocated(text[i].address + 4);
+                inst.entry = isaFind(invertedName(inst.entry->id));
+                inst.word = isaEncode(*inst.entry, 0, rs1Field(inst.word), rs2Field(inst.word), 0);
+                problem = relocateWord(RelocationType::Target, *inst.entry, inst.word, fallThrough, inst.address);
+                inst.assembly = controlLine(lines, text[i].assembly, string(inst.entry->asmName) + " x" + to_string(rs1Field(inst.word)) + ", x" + to_string(rs2Field(inst.word)) + ", " + targetText(symbols, text[i].address + 4, fallThrough - inst.address, textEnd));
+                inst.symbol = -1;
+                inst.pending = false;
+                report.inverted++;
+            }
+            else if (inst.symbol >= 0 && symbols[inst.symbol].defined) {
+                const Symbol &label = symbols[inst.symbol];
+                LongInt value = label.value <= textEnd ? relocated(label.value) : label.value;
+                problem = relocateWord(inst.relocation, *inst.entry, inst.word, value, inst.address);
+                inst.pending = false;
+            }
+            else if (inst.symbol < 0 && control) {
+                problem = relocateWord(RelocationType::Target, *inst.entry, inst.word, relocated(text[i].address + isaImmediate(type, text[i].word)), inst.address);
+            }
+            if (problem != nullptr) return LayoutReport{0, 0, 0, report.stale, report.takenBefore, report.takenBefore};
+            laid.push_back(move(inst));
+        }
+        if (fix[b] == Fix::AddJump) {
+            const AssembledInstruction &branch = text[blocks[b].end - 1];
+            LongInt fallThrough = relocated(branch.address + 4);
+            AssembledInstruction jump = branch;
+            jump.address = moved[blocks[b].end - 1] + 4;
+            jump.entry = isaFind("jal");
+            jump.word = isaEncode(*jump.entry, 0, 0, 0, 0);
+            jump.symbol = -1;
+            jump.pending = false;
+            jump.column = 0;
+            if (relocateWord(RelocationType::Target, *jump.entry, jump.word, fallThrough, jump.address) != nullptr) {
+                return LayoutReport{0, 0, 0, report.stale, report.takenBefore, report.takenBefore};
+            }
+            jump.assembly = controlLine(lines, branch.assembly, "jal x0, " + targetText(symbols, branch.address + 4, fallThrough - jump.address, textEnd));
+            laid.push_back(move(jump));
+            report.jumps++;
+        }
+    }
+    text = move(laid);
+
+    for (LongInt &label : textLabels) {
+        label = relocated(label);
+    }
+    for (int id = 0; id < symbols.size(); id++) {
+        if (symbols[id].defined && symbols[id].value <= textEnd) symbols.define(id, relocated(symbols[id].value));
+    }
+    return report;
+}
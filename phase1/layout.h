@@ -0,0 +1,46 @@
+#include<vector>
+#include<deque>
+#include<string>
+#include<unordered_map>
+#include<process.h>
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+using namespace std;
+
+// Outcomes of the conditional branch at one text address, from the
+// "pc taken not-taken" lines rvsim --profile writes
+struct BranchCount {
+    uint64_t taken = 0;
+    uint64_t notTaken = 0;
+};
+typedef unordered_map<LongInt, BranchCount> BranchProfile;
+
+struct LayoutReport {
+    size_t moved = 0;           // Blocks placed away from their source position
+    size_t inverted = 0;        // Branches whose condition was flipped
+    size_t jumps = 0;           // jal x0 added after a branch whose fall-through moved away
+    size_t stale = 0;           // Profile entries that name no branch of the text
+    uint64_t takenBefore = 0;   // Taken branches of the profiled run in the source order
+    uint64_t takenAfter = 0;    // The same run in the new order, counting the added jumps
+};
+
+// Read a profile written by rvsim --profile; false with the reason in error
+bool readBranchProfile(const string &path, BranchProfile &profile, string &error);
+
+// Reorder the basic blocks of text so that the hot successor of each
+// profiled branch falls through. Blocks joined by a fall-through that is
+// not a branch stay together, and so do a call and its return point; the
+// first block stays first and a block that runs off the end stays last.
+// Chains are merged along branch edges from the most executed down. A
+// branch whose taken target now follows it is inverted, and one whose
+// both successors moved away gets a "jal x0" to its old fall-through.
+// Labels in symbols and textLabels, label operands and numeric offsets
+// are then moved with their blocks; nothing changes if a branch would
+// leave its range or if text has lines with errors. Profile addresses
+// are those of the same text assembled without a profile. Rewritten
+// lines get their assembly text from lines, which must outlive the
+// instructions.
+LayoutReport layoutText(vector<AssembledInstruction> &text, vector<LongInt> &textLabels, SymbolTable &symbols, deque<string> &lines, const BranchProfile &profile);
+
+#endif
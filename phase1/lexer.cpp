@@ -0,0 +1,121 @@
+#include<lexer.h>
+#include<cstring>
+#include<fstream>
+#include<sstream>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+using namespace std;
+
+SourceFile::~SourceFile() {
+    if (mapped) {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+bool SourceFile::open(const char *path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(map);
+            size = info.st_size;
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    if (mapped) {
+        return true;
+    }
+
+    // Pipes and empty or unmappable files are read into memory
+    ifstream file(path, ios::binary);
+    if (!file) {
+        return false;
+    }
+    ostringstream contents;
+    contents << file.rdbuf();
+    buffer = contents.str();
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+}
+
+bool SourceLines::next(string_view &line, int &lineNumber) {
+    if (cursor >= text.size()) {
+        return false;
+    }
+    const char *start = text.data() + cursor;
+    const char *end = static_cast<const char *>(memchr(start, '\n', text.size() - cursor));
+    size_t length = end ? end - start : text.size() - cursor;
+    line = string_view(start, length);
+    cursor += length + 1;
+    lineNumber = ++lineCount;
+    return true;
+}
+
+static bool isSeparator(char c) {
+    return c == ',' || c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Only the first maxTokens tokens are kept, for a quick look at a line
+void LineTokens::split(string_view text, int lineNumber, size_t maxTokens) {
+    tokens.clear();
+    position = 0;
+    line = lineNumber;
+    errorColumn = 0;
+    error.clear();
+
+    size_t i = 0;
+    while (i < text.size() && tokens.size() < maxTokens) {
+        if (isSeparator(text[i])) {
+            i++;
+            continue;
+        }
+        if (text[i] == '#') {
+            break;
+        }
+        size_t start = i;
+        if (text[i] == '"' || text[i] == '\'') {
+            // Quoted token runs to the closing quote
+            size_t close = text.find(text[i], i + 1);
+            i = (close == string_view::npos) ? text.size() : close + 1;
+            while (i < text.size() && !isSeparator(text[i])) i++;
+        } else {
+            while (i < text.size() && !isSeparator(text[i])) i++;
+        }
+        tokens.push_back({text.substr(start, i - start), static_cast<int>(start) + 1});
+    }
+    endColumn = tokens.empty() ? 1 : tokens.back().column + tokens.back().text.size();
+}
+
+bool LineTokens::next(Token &token) {
+    if (position == tokens.size()) {
+        return false;
+    }
+    token = tokens[position++];
+    return true;
+}
+
+// Next operand, or a "missing operand" error at the end of the line
+bool LineTokens::operand(Token &token) {
+    if (next(token)) {
+        return true;
+    }
+    return fail({string_view(), endColumn}, "missing operand");
+}
+
+bool LineTokens::fail(const Token &at, const string &message) {
+    if (error.empty()) {
+        errorColumn = at.column;
+        error = message;
+    }
+    return false;
+}
@@ -0,0 +1,64 @@
+#include<string>
+#include<string_view>
+#include<vector>
+#include<cstdint>
+
+#ifndef LEXER_H
+#define LEXER_H
+using namespace std;
+
+// Whole source file, memory-mapped when possible. Tokens and lines are
+// string_views into it, so it must outlive everything assembled from it.
+class SourceFile {
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+    ~SourceFile();
+
+    bool open(const char *path);
+    string_view text() const { return string_view(data, size); }
+
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    string buffer;       // Contents when the file could not be mapped
+};
+
+// Lines of a source text
+class SourceLines {
+public:
+    explicit SourceLines(string_view text) : text(text) {}
+
+    // Next line without its '\n', numbered from 1; false at the end
+    bool next(string_view &line, int &lineNumber);
+
+private:
+    string_view text;
+    size_t cursor = 0;
+    int lineCount = 0;
+};
+
+struct Token {
+    string_view text;
+    int column;         // 1-based
+};
+
+// Tokens of one line. Whitespace and commas separate tokens, a quoted
+// string or character stays one token, and '#' starts a comment.
+struct LineTokens {
+    vector<Token> tokens;
+    size_t position = 0;
+    int line = 0;
+    int endColumn = 1;  // Column just past the last token
+    int errorColumn = 0;
+    string error;       // First problem found on the line
+
+    void split(string_view text, int lineNumber, size_t maxTokens = SIZE_MAX);
+    bool next(Token &token);
+    bool operand(Token &token);
+    bool fail(const Token &at, const string &message);
+};
+
+#endif
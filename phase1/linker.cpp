@@ -0,0 +1,158 @@
+#include<linker.h>
+#include<unordered_map>
+#include<algorithm>
+
+using namespace std;
+
+// Where link() put one object
+struct Placement {
+    LongInt text;       // Address of its first instruction
+    LongInt data;       // Offset of its data in the linked data segment
+    size_t stored;      // DataSegment::nextByte() of its first stored byte
+};
+
+static void linkError(string &errors, const ObjectFile &object, const ObjectInstruction &inst, int column, const string &message) {
+    errors += "Error in linking: ";
+    errors += inst.assembly;
+    errors += " (" + object.name + ":" + to_string(inst.line) + ":" + to_string(column) + ": " + message + ")\n";
+}
+
+// Object defining the entry point and its text offset there: a global
+// main, else the main of the first object with one; false if none has
+static bool findEntry(const vector<const ObjectFile *> &objects, size_t &object, LongInt &offset) {
+    bool found = false;
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (const ObjectSymbol &symbol : objects[i]->symbols) {
+            if (symbol.name != "main" || symbol.value >= DATA_BASE || (found && !symbol.global)) continue;
+            object = i;
+            offset = symbol.value;
+            if (symbol.global) return true;
+            found = true;
+        }
+    }
+    return found;
+}
+
+ProgramImage link(const vector<const ObjectFile *> &objects, const AssemblerOptions &options) {
+    ProgramImage image;
+    string errors;
+    vector<Placement> placements;
+    vector<const IsaEntry *> entries;   // Per word, nullptr where the line failed
+
+    // output.mc has no entry field and runs from address 0, so unless main
+    // lands there the text starts with a jump to it
+    size_t entryObject = 0;
+    LongInt entryOffset = 0;
+    bool entryJump = findEntry(objects, entryObject, entryOffset) && (entryObject != 0 || entryOffset != 0);
+    const IsaEntry *jal = isaFind("jal");
+    if (entryJump) {
+        image.text.push_back(isaEncode(*jal, 0, 0, 0, 0));
+        entries.push_back(jal);
+    }
+    for (const ObjectFile *object : objects) {
+        errors += object->errors;
+        image.peephole.removed += object->peephole.removed;
+        image.peephole.folded += object->peephole.folded;
+        image.peephole.reduced += object->peephole.reduced;
+        image.layout.moved += object->layout.moved;
+        image.layout.inverted += object->layout.inverted;
+        image.layout.jumps += object->layout.jumps;
+        image.layout.stale += object->layout.stale;
+        image.layout.takenBefore += object->layout.takenBefore;
+        image.layout.takenAfter += object->layout.takenAfter;
+        image.schedule.stallsBefore += object->schedule.stallsBefore;
+        image.schedule.stallsAfter += object->schedule.stallsAfter;
+        image.schedule.moved += object->schedule.moved;
+        image.data.align(DATA_BASE, max<LongInt>(8, object->data.alignment()));
+        placements.push_back({static_cast<LongInt>(image.text.size()) * 4, image.data.size(), image.data.nextByte()});
+        for (const ObjectInstruction &inst : object->text) {
+            image.text.push_back(inst.word);
+            entries.push_back(inst.entry);
+        }
+        image.data.append(object->data);
+    }
+
+    // Final address of every label, per object and for the .globl ones
+    vector<unordered_map<string_view, LongInt>> locals(objects.size());
+    unordered_map<string_view, size_t> definedIn;
+    unordered_map<string_view, LongInt> globals;
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (const ObjectSymbol &symbol : objects[i]->symbols) {
+            LongInt address = symbol.value >= DATA_BASE ? symbol.value + placements[i].data : symbol.value + placements[i].text;
+            locals[i][symbol.name] = address;
+            image.symbols.emplace_back(symbol.name, address);
+            if (!symbol.global) continue;
+            auto defined = definedIn.emplace(symbol.name, i);
+            if (defined.second) {
+                globals[symbol.name] = address;
+            }
+            else {
+                errors += "Error in linking: global label '" + symbol.name + "' is defined in both "
+                          + objects[defined.first->second]->name + " and " + objects[i]->name + "\n";
+            }
+        }
+    }
+
+    for (size_t i = 0; i < objects.size(); i++) {
+        const ObjectFile &object = *objects[i];
+        for (const Relocation &relocation : object.relocations) {
+            auto found = locals[i].find(relocation.symbol);
+            bool defined = found != locals[i].end();
+            if (!defined) {
+                found = globals.find(relocation.symbol);
+                defined = found != globals.end();
+            }
+            if (relocation.type == RelocationType::Data) {
+                // As in one file, a data value naming no label keeps its ASCII reading
+                image.data.patch(placements[i].stored + relocation.offset, defined ? found->second : relocation.fallback, relocation.size);
+                continue;
+            }
+            size_t index = (placements[i].text + relocation.offset) / 4;
+            const ObjectInstruction &inst = object.text[relocation.offset / 4];
+            const char *problem = "undefined label";
+            if (defined) {
+                problem = relocateWord(relocation.type, *inst.entry, image.text[index], found->second, placements[i].text + relocation.offset);
+            }
+            if (problem != nullptr) {
+                linkError(errors, object, inst, relocation.column, problem + (" '" + relocation.symbol + "'"));
+                image.text[index] = 0;
+                entries[index] = nullptr;
+            }
+        }
+    }
+
+    if (entryJump) {
+        image.entry = placements[entryObject].text + entryOffset;
+        const char *problem = relocateWord(RelocationType::Target, *jal, image.text[0], image.entry, 0);
+        if (problem != nullptr) {
+            errors += "Error in linking: jal x0, main (" + string(problem) + " 'main')\n";
+            entries[0] = nullptr;
+        }
+    }
+
+    if (options.listing) {
+        image.listing.emplace_back();
+        string &text = image.listing.back();
+        text.reserve(image.text.size() * (options.decodedColumn ? 96 : 48));
+        size_t index = 0;
+        if (entryJump) {
+            if (entries[0] != nullptr) formatListingLine(text, 0, image.text[0], "    jal x0, main", *jal, options.decodedColumn);
+            index++;
+        }
+        for (const ObjectFile *object : objects) {
+            for (const ObjectInstruction &inst : object->text) {
+                if (entries[index] != nullptr) {
+                    formatListingLine(text, index * 4, image.text[index], inst.assembly, *entries[index], options.decodedColumn);
+                }
+                index++;
+            }
+        }
+        image.listing.emplace_back();
+        image.listing.back().reserve(image.data.nextByte() * 3 + 64);
+        image.data.format(image.listing.back(), DATA_BASE);
+    }
+
+    sortSymbols(image.symbols);
+    image.errors = move(errors);
+    return image;
+}
@@ -0,0 +1,19 @@
+#include<string>
+#include<vector>
+#include<assembler.h>
+
+#ifndef LINKER_H
+#define LINKER_H
+using namespace std;
+
+// Lay out objects in order, text from address 0 and data from DATA_BASE
+// with each object's data aligned to 8 bytes or its largest .align, and
+// resolve their relocations. A label is looked up in its own object first,
+// then among the .globl labels of all objects. The entry point is a global
+// main, else the main of the first object with one; unless that is address
+// 0, the text starts with a jal x0 to it, as output.mc has no entry field
+// and the simulator runs it from 0. options.listing and
+// options.decodedColumn shape the listing as for assemble().
+ProgramImage link(const vector<const ObjectFile *> &objects, const AssemblerOptions &options = AssemblerOptions());
+
+#endif
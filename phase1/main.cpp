@@ -1,193 +1,321 @@
-#include<encode.h>
-#include<assign.h>
-#include<process.h>
+#include<assembler.h>
+#include<linker.h>
+#include<elfWriter.h>
 #include<vector>
-#include<map>
-#include<sstream>
-#include<fstream>
+#include<set>
+#include<thread>
+#include<atomic>
+#include<climits>
+#include<chrono>
+#include<fcntl.h>
+#include<sys/uio.h>
+#include<sys/inotify.h>
+#include<poll.h>
+#include<unistd.h>
 
 using namespace std;
 
-#define LongInt long long
-#define ERROR_VAL 1e18
-LongInt MemoryStart = (1ll << 28);
-map<string, LongInt> symbolTable;
-LongInt instructionPointer = 0; // Program counter
-LongInt dataSize = 0;
-vector<string> binaryInstructions; // Store the binary format of instructions
-vector<LongInt> instructionAddresses;
-// Instruction formats:
-// R format: funct7 | rs2 | rs1 | funct3 | rd | opcode
-// I format: imm[11:0] | rs1 | funct3 | rd | opcode
-// etc.
-unordered_map<string, string> registerMap;
-vector<string> decodedInstructions;
-vector<string> assemblyLines;
-
-
-string convertBinaryToHex(string binaryStr) {
-    // Converts a 32-bit binary string to hexadecimal
-    string hexOutput = "0x";
-    for (LongInt i = 0; i < 32; i += 4) {
-        string segment;
-        LongInt value = 0;
-        for (LongInt j = i; j < i + 4; j++)
-            binaryStr[j] == '0' ? value *= 2 : value = value * 2 + 1;
-        if (value >= 10)
-            hexOutput += 'A' + value - 10;
-        else
-            hexOutput += '0' + value;
-    }
-    return hexOutput;
+// Command-line settings
+AssemblerOptions options;
+const char *elfPath = nullptr;  // Also write an ELF executable here
+bool watchMode = false;         // Re-assemble whenever the input changes
+const char *runCommand = nullptr; // Shell command run after each clean assembly
+vector<string> inputFiles;      // Sources assembled separately and linked, instead of input.asm
+
+// Object of each input file, with the source it was assembled from
+struct CachedObject {
+    string source;
+    ObjectFile object;
+};
+unordered_map<string, CachedObject> objectCache;
+
+
+// Write the buffers to path in order with as few writev calls as possible
+bool writeOutput(const char *path, const vector<string> &buffers) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    vector<iovec> pieces;
+    for (const string &buffer : buffers) {
+        if (!buffer.empty()) {
+            pieces.push_back({const_cast<char *>(buffer.data()), buffer.size()});
+        }
+    }
+    size_t next = 0;
+    while (next < pieces.size()) {
+        int count = min<size_t>(pieces.size() - next, IOV_MAX);
+        ssize_t written = writev(fd, &pieces[next], count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            close(fd);
+            return false;
+        }
+        // Skip what was written, resuming inside a partly written buffer
+        while (next < pieces.size() && static_cast<size_t>(written) >= pieces[next].iov_len) {
+            written -= pieces[next++].iov_len;
+        }
+        if (written > 0) {
+            pieces[next].iov_base = static_cast<char *>(pieces[next].iov_base) + written;
+            pieces[next].iov_len -= written;
+        }
+    }
+    return close(fd) == 0;
+}
+
+void printUsage() {
+    cout << "Usage: assembler [-j N] [--no-decode] [--elf FILE] [-O] [--profile FILE]\n"
+            "                 [--schedule RULES] [--watch] [--run COMMAND] [FILE.asm...]\n"
+            "Assembles input.asm into output.mc. Given files, assembles each into an\n"
+            "object and links them into output.mc instead.\n"
+            "  -j, --threads N   Encode .text, or assemble files, on N threads\n"
+            "                    (0: all cores, default 1)\n"
+            "      --no-decode   Leave out the decoded-fields column\n"
+            "      --elf FILE    Also write an ELF32 executable to FILE\n"
+            "  -O, --optimize    Delete no-op moves, fold addi chains and replace mul, div\n"
+            "                    and rem by known constants with cheaper instructions\n"
+            "      --profile FILE\n"
+            "                    Reorder basic blocks so the hot side of each branch in\n"
+            "                    FILE (from rvsim --profile) falls through; one input only\n"
+            "      --schedule RULES\n"
+            "                    Reorder instructions within basic blocks to avoid the\n"
+            "                    data-hazard stalls of the simulator with forwarding or\n"
+            "                    no-forwarding, and report the stalls it expects\n"
+            "      --watch       Re-assemble whenever the input changes, re-encoding\n"
+            "                    only the lines or files that need it\n"
+            "      --run COMMAND Run COMMAND after each assembly without errors\n";
 }
 
-void processInstruction(string instruction) {
-    // Process each instruction and encode it
-    istringstream tokenizer(instruction);
-    string mnemonic;
-    tokenizer >> mnemonic;
-    string token = mnemonic;
-    if (token[token.size() - 1] != ':') {
-        tokenizer >> mnemonic;
+// Print the errors of program and write output.mc and the ELF file
+bool writeProgram(const ProgramImage &program) {
+    cout << program.errors;
+    if (options.optimize) {
+        cout << "Peephole: " << program.peephole.removed << " no-op moves removed, " << program.peephole.folded
+             << " addi instructions folded, " << program.peephole.reduced << " mul/div/rem reduced\n";
     }
-    
-    if (mnemonic == ":" || token[token.size() - 1] == ':') return;
-    mnemonic = token;
-    if (token == "add" || token == "sub" || token == "mul" || token == "div" || 
-        token == "sll" || token == "srl" || token == "sra" || token == "slt" || 
-        token == "xor" || token == "or" || token == "and" || token == "rem") {
-        processRType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, registerMap);
+    if (!options.profile.empty()) {
+        const LayoutReport &layout = program.layout;
+        cout << "Layout: " << layout.moved << " blocks moved, " << layout.inverted << " branches inverted, "
+             << layout.jumps << " jumps added; taken branches in the profiled run: " << layout.takenBefore
+             << " before, " << layout.takenAfter << " after\n";
+        if (layout.stale > 0) {
+            cout << "Layout: " << layout.stale << " profile entries name no branch; the profile may be from another build\n";
+        }
     }
-    else if (token == "addi" || token == "andi" || token == "ori" || token == "jalr") {
-        processIType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, registerMap);
+    if (options.schedule) {
+        cout << "Scheduling: " << program.schedule.stallsBefore << " expected stall cycles before, "
+             << program.schedule.stallsAfter << " after (" << program.schedule.moved << " instructions moved)\n";
     }
-    else if (token == "lb" || token == "ld" || token == "lw" || token == "lh") {
-        processLoadType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, registerMap);
+    cout << flush;
+    if (!writeOutput("output.mc", program.listing)) {
+        cerr << "Cannot write output.mc" << endl;
+        return false;
     }
-    else if (token == "sb" || token == "sh" || token == "sw" || token == "sd") {
-        processStoreType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, registerMap);
+
+    // An executable with holes in it would be worse than none
+    if (elfPath != nullptr) {
+        if (!program.ok()) {
+            cerr << "Not writing " << elfPath << ": the program has errors" << endl;
+            return false;
+        }
+        if (!writeOutput(elfPath, {elfImage(program)})) {
+            cerr << "Cannot write " << elfPath << endl;
+            return false;
+        }
     }
-    else if (token == "beq" || token == "bne" || token == "blt" || token == "bge") {
-        processBranchType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, symbolTable, registerMap);
+    return true;
+}
+
+// Assemble input.asm into output.mc (and the ELF file); returns an exit
+// status, and in clean whether the program had no errors
+int assembleInput(Assembler &assembler, bool &clean) {
+    auto start = chrono::steady_clock::now();
+    clean = false;
+
+    // The source stays mapped until the image is built; lines, tokens
+    // and label names all point into it
+    SourceFile file;
+    if (!file.open("input.asm")) {
+        cerr << "Cannot open input.asm" << endl;
+        return 1;
     }
-    else if (token == "auipc" || token == "lui") {
-        processUpperImmediate(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, registerMap);
+    ProgramImage program = assembler.assemble(file.text());
+    if (!writeProgram(program)) {
+        return 1;
     }
-    else if (token == "jal") {
-        processJumpType(instruction, binaryInstructions, decodedInstructions, assemblyLines, instructionAddresses, instructionPointer, symbolTable, registerMap);
+
+    if (watchMode) {
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Assembled input.asm in " << milliseconds << " ms (" << program.encodedLines << " of "
+             << program.text.size() << " lines encoded)" << endl;
+    }
+    clean = program.ok();
+    return 0;
+}
+
+// Assemble the input files that changed since their cached objects, on
+// options.threads threads, then link them all. Unlike a single input, a
+// link with errors fails: its output.mc would run with holes in it.
+int linkInputs(bool &clean) {
+    auto start = chrono::steady_clock::now();
+    clean = false;
+
+    vector<string> sources(inputFiles.size());
+    vector<size_t> changed;
+    for (size_t i = 0; i < inputFiles.size(); i++) {
+        SourceFile file;
+        if (!file.open(inputFiles[i].c_str())) {
+            cerr << "Cannot open " << inputFiles[i] << endl;
+            return 1;
+        }
+        sources[i] = string(file.text());
+        auto cached = objectCache.find(inputFiles[i]);
+        if (cached == objectCache.end() || cached->second.source != sources[i]) {
+            changed.push_back(i);
+        }
     }
-    else {
-        binaryInstructions.push_back("error");
-        decodedInstructions.push_back("error");
-        assemblyLines.push_back(instruction);
-        instructionAddresses.push_back(instructionPointer);
+
+    vector<ObjectFile> objects(changed.size());
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t job = next++; job < changed.size(); job = next++) {
+            AssemblerOptions fileOptions = options;
+            fileOptions.sourceName = inputFiles[changed[job]];
+            objects[job] = Assembler(fileOptions).assembleObject(sources[changed[job]]);
+        }
+    };
+    vector<thread> workers;
+    for (unsigned t = 1; t < options.threads && t < changed.size(); t++) {
+        workers.emplace_back(worker);
     }
-    instructionPointer += 4;
+    worker();
+    for (thread &t : workers) {
+        t.join();
+    }
+    for (size_t job = 0; job < changed.size(); job++) {
+        const string &name = inputFiles[changed[job]];
+        objectCache[name] = {move(sources[changed[job]]), move(objects[job])};
+    }
+
+    vector<const ObjectFile *> linked;
+    for (const string &name : inputFiles) {
+        linked.push_back(&objectCache[name].object);
+    }
+    ProgramImage program = link(linked, options);
+    if (!writeProgram(program)) {
+        return 1;
+    }
+
+    if (watchMode) {
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "Linked " << inputFiles.size() << " files in " << milliseconds << " ms ("
+             << changed.size() << " assembled)" << endl;
+    }
+    clean = program.ok();
+    return clean ? 0 : 1;
 }
 
-void readInstruction (string instruction) {
-    istringstream tokenizer(instruction);
-    string mnemonic;
-    tokenizer >> mnemonic;
-    string token = mnemonic;
-    if (token[token.size() - 1] != ':') {
-        tokenizer >> mnemonic;
-    }
-    LongInt size = token.size();
-    if (mnemonic == ":" || token[token.size() - 1] == ':') {
-        if (token[token.size() - 1] == ':') size--;
-        string label;
-        for (LongInt i = 0; i < size; i++) {
-            label += token[i];
-        }
-        symbolTable[label] = instructionPointer;
-        return;
-    }
-    instructionPointer += 4;
+// Assemble, then run runCommand if there were no errors
+int assembleAndRun(Assembler &assembler) {
+    bool clean;
+    int status = inputFiles.empty() ? assembleInput(assembler, clean) : linkInputs(clean);
+    if (clean && runCommand != nullptr) {
+        status = system(runCommand) == 0 ? 0 : 1;
+    }
+    return status;
+}
+
+// Watch the directories of the input for it being written or replaced
+// (editors often save by renaming) and assemble each time until interrupted
+int watchInput(Assembler &assembler) {
+    set<string> directories, names;
+    for (const string &path : inputFiles) {
+        size_t slash = path.rfind('/');
+        directories.insert(slash == string::npos ? "." : path.substr(0, slash + 1));
+        names.insert(slash == string::npos ? path : path.substr(slash + 1));
+    }
+    if (inputFiles.empty()) {
+        directories.insert(".");
+        names.insert("input.asm");
+    }
+    int fd = inotify_init1(IN_CLOEXEC);
+    bool watching = fd >= 0;
+    for (const string &directory : directories) {
+        watching = watching && inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0;
+    }
+    if (!watching) {
+        cerr << "Cannot watch the input" << endl;
+        return 1;
+    }
+    assembleAndRun(assembler);
+
+    alignas(inotify_event) char events[4096];
+    while (true) {
+        ssize_t length = read(fd, events, sizeof(events));
+        if (length < 0 && errno == EINTR) continue;
+        if (length <= 0) break;
+        bool changed = false;
+        for (char *p = events; p < events + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event *>(p)->len) {
+            inotify_event *event = reinterpret_cast<inotify_event *>(p);
+            changed |= event->len > 0 && names.count(event->name) > 0;
+        }
+        if (!changed) continue;
+
+        // Let a save that comes as several events settle first
+        pollfd pending{fd, POLLIN, 0};
+        while (poll(&pending, 1, 50) > 0 && read(fd, events, sizeof(events)) > 0) {
+        }
+        assembleAndRun(assembler);
+    }
+    close(fd);
+    return 1;
 }
 
-int main () {
-    setupRegisterMapping(registerMap);
-    ofstream op("output.mc");   
-    ifstream file("input.asm");
-
-    string instruction;
-    LongInt memoryArray[204];
-    for (LongInt i = 0; i < 204; i++)
-        memoryArray[i] = 0;
-    
-    LongInt check = 0;
-    LongInt memory = MemoryStart;
-
-    while (getline(file, instruction)) {
-        if (instruction == ".data") {
-            while (getline(file, instruction)) {
-                if (instruction == ".text") {
-                    break;
-                }
-                processDataDirective(instruction, memoryArray, dataSize, memory, symbolTable);
-            }
-        } else if (instruction == ".text") continue;
-        else readInstruction(instruction);
-    }
-    file.close();
-
-    ifstream file2("input.asm");
-    instructionPointer = 0;
-
-    while (getline(file2, instruction)) {
-        if (instruction == ".data") {
-            while (getline(file2, instruction)) {
-                if (instruction == ".text") {
-                    break;
-                }
-            }
-        } else if (instruction == ".text") continue;
-        else processInstruction(instruction);
-    }
-
-    LongInt counter = 0;
-    for (auto i = 0; i<binaryInstructions.size(); i++) {
-        if (binaryInstructions[i] == "error") {
-            cout << "Error in encoding instruction: " << assemblyLines[i] << endl;
-            continue;
-        }
-        else if (binaryInstructions[i][0] == '0' || binaryInstructions[i][0] == '1') {
-            op << "0x";
-            op <<hex << instructionAddresses[counter] << " , ";
-            op << convertBinaryToHex(binaryInstructions[i]) + " " + assemblyLines[i] + " " + "#" + " " + decodedInstructions[i] << endl;
+int main (int argc, char *argv[]) {
+    const char *profilePath = nullptr;
+    options.listing = true;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage();
+            return 0;
+        }
+        else if (arg == "--no-decode") options.decodedColumn = false;
+        else if (arg == "--elf" && i + 1 < argc) elfPath = argv[++i];
+        else if (arg == "--schedule" && i + 1 < argc && (string(argv[i + 1]) == "forwarding" || string(argv[i + 1]) == "no-forwarding")) {
+            options.schedule = true;
+            options.forwarding = string(argv[++i]) == "forwarding";
+        }
+        else if (arg == "-O" || arg == "--optimize") options.optimize = true;
+        else if (arg == "--profile" && i + 1 < argc) profilePath = argv[++i];
+        else if (arg == "--watch") watchMode = true;
+        else if (arg == "--run" && i + 1 < argc) runCommand = argv[++i];
+        else if ((arg == "-j" || arg == "--threads") && i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+            options.threads = atoi(argv[++i]);
+            if (options.threads == 0) options.threads = max(1u, thread::hardware_concurrency());
         }
+        else if (arg[0] != '-') inputFiles.push_back(arg);
         else {
-            op << binaryInstructions[i] <<endl;
-        }
-        counter++;
-    }
-    op << endl << endl ;
-    op << "***********************************************************************************************" <<endl;
-    op << "Data Segment" << endl;
-
-    for (LongInt i =0 ; i<204; i += 4){
-        op << "0x";
-        op << hex << MemoryStart  << "   ";
-        for (LongInt j = i; j < i+4; j++) {
-            LongInt value = memoryArray[j];
-            string result = "00";
-            LongInt rem = value%16;
-            if (rem > 9) result[1] = rem - 10 + 'A';
-            else result[1] = rem + '0';
-            value /= 16;
-            rem = value % 16;
-            if (rem > 9) result[0] = rem - 10 + 'A';
-            else result[0] = rem + '0';
-            op << result << " " ;
-        }
-        op<< endl;
-        MemoryStart += 4;
-    }
-
-    op.close();
-    file2.close();
-    return 0;
+            cerr << "assembler: bad option " << arg << " (see --help)" << endl;
+            return 1;
+        }
+    }
 
+    // Profile addresses are those of one file's text
+    if (profilePath != nullptr) {
+        string error;
+        if (inputFiles.size() > 1) {
+            cerr << "assembler: --profile needs a single input file" << endl;
+            return 1;
+        }
+        if (!readBranchProfile(profilePath, options.profile, error)) {
+            cerr << "assembler: " << error << endl;
+            return 1;
+        }
+    }
 
-}
\ No newline at end of file
+    // Watch mode keeps encodings between runs
+    options.cache = watchMode;
+    Assembler assembler(options);
+    return watchMode ? watchInput(assembler) : assembleAndRun(assembler);
+}
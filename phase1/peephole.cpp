@@ -0,0 +1,307 @@
+#include<peephole.h>
+#include<algorithm>
+
+using namespace std;
+
+// Register operands of an encoded instruction, -1 where it has none
+struct Operands {
+    int rd;
+    int rs1;
+    int rs2;
+    int32_t imm;
+};
+
+static Operands operandsOf(const AssembledInstruction &inst) {
+    const IsaEntry &entry = *inst.entry;
+    int32_t imm = isaImmediate(entry.type, inst.word);
+    return {layoutWritesRd(entry.layout) ? static_cast<int>(rdField(inst.word)) : -1,
+            layoutReadsRs1(entry.layout) ? static_cast<int>(rs1Field(inst.word)) : -1,
+            layoutReadsRs2(entry.layout) ? static_cast<int>(rs2Field(inst.word)) : -1,
+            isaShiftImmediate(entry) ? imm & 0x1F : imm};
+}
+
+static bool reads(const Operands &op, int reg) {
+    return reg > 0 && (op.rs1 == reg || op.rs2 == reg);
+}
+
+static bool writes(const Operands &op, int reg) {
+    return reg > 0 && op.rd == reg;
+}
+
+// Instructions the pass must not look through: failed lines, control
+// transfers, pc-relative ones and fence, ecall and ebreak
+static bool opaque(const AssembledInstruction &inst) {
+    if (inst.entry == nullptr) return true;
+    InstType type = inst.entry->type;
+    return type == InstType::SB || type == InstType::JAL || type == InstType::JALR || type == InstType::AUIPC ||
+           inst.entry->layout == OperandLayout::None;
+}
+
+// Replace inst with a new instruction of the given mnemonic, recording its
+// assembly text in lines
+static void rewrite(AssembledInstruction &inst, deque<string> &lines, const char *name, int rd, int rs1, int rs2, int32_t imm) {
+    inst.entry = isaFind(name);
+    inst.word = isaEncode(*inst.entry, rd, rs1, rs2, imm);
+    // Keep the indentation of the source line in the listing
+    size_t indent = inst.assembly.find_first_not_of(" \t");
+    string text(inst.assembly.substr(0, indent == string_view::npos ? 0 : indent));
+    text += string(name) + " x" + to_string(rd) + ", x" + to_string(rs1);
+    text += inst.entry->layout == OperandLayout::RdRs1Rs2 ? ", x" + to_string(rs2) : ", " + to_string(imm);
+    lines.push_back(move(text));
+    inst.assembly = lines.back();
+    inst.symbol = -1;
+}
+
+static bool isNoOpMove(const AssembledInstruction &inst) {
+    Operands op = operandsOf(inst);
+    if (op.rd != op.rs1) return false;
+    switch (inst.entry->id) {
+    case Mnemonic::ADDI:
+    case Mnemonic::ORI:
+    case Mnemonic::XORI:
+        // addi x0, x0, 1 stops the pipelined simulator, so only 0 is a no-op
+        return op.imm == 0 && inst.symbol < 0;
+    case Mnemonic::SLLI:
+    case Mnemonic::SRLI:
+    case Mnemonic::SRAI:
+        return op.imm == 0;
+    case Mnemonic::ADD:
+    case Mnemonic::SUB:
+    case Mnemonic::OR:
+    case Mnemonic::XOR:
+    case Mnemonic::SLL:
+    case Mnemonic::SRL:
+    case Mnemonic::SRA:
+        return op.rs2 == 0;
+    default:
+        return false;
+    }
+}
+
+// Register contents known within a block
+struct Constants {
+    bool known[32];
+    int32_t value[32];
+
+    void reset() {
+        fill(known, known + 32, false);
+        known[0] = true;
+        value[0] = 0;
+    }
+
+    bool get(int reg, int32_t &out) const {
+        if (reg < 0 || !known[reg]) return false;
+        out = value[reg];
+        return true;
+    }
+
+    void update(const AssembledInstruction &inst) {
+        if (inst.entry == nullptr) {
+            reset();
+            return;
+        }
+        Operands op = operandsOf(inst);
+        if (op.rd <= 0) return;
+        int32_t a = 0, b = 0;
+        bool result = true;
+        uint32_t u = 0;
+        switch (inst.entry->id) {
+        case Mnemonic::ADDI: result = inst.symbol < 0 && get(op.rs1, a); u = static_cast<uint32_t>(a) + op.imm; break;
+        case Mnemonic::ANDI: result = inst.symbol < 0 && get(op.rs1, a); u = a & op.imm; break;
+        case Mnemonic::ORI: result = inst.symbol < 0 && get(op.rs1, a); u = a | op.imm; break;
+        case Mnemonic::XORI: result = inst.symbol < 0 && get(op.rs1, a); u = a ^ op.imm; break;
+        case Mnemonic::SLLI: result = get(op.rs1, a); u = static_cast<uint32_t>(a) << op.imm; break;
+        case Mnemonic::SRLI: result = get(op.rs1, a); u = static_cast<uint32_t>(a) >> op.imm; break;
+        case Mnemonic::SRAI: result = get(op.rs1, a); u = a >> op.imm; break;
+        case Mnemonic::LUI: result = inst.symbol < 0; u = op.imm; break;
+        case Mnemonic::ADD: result = get(op.rs1, a) && get(op.rs2, b); u = static_cast<uint32_t>(a) + b; break;
+        case Mnemonic::SUB: result = get(op.rs1, a) && get(op.rs2, b); u = static_cast<uint32_t>(a) - b; break;
+        default: result = false; break;
+        }
+        known[op.rd] = result;
+        value[op.rd] = static_cast<int32_t>(u);
+    }
+};
+
+// Cheaper form of mul, div, rem, divu or remu by a known constant; true
+// if inst was rewritten
+static bool reduce(AssembledInstruction &inst, const Constants &constants, deque<string> &lines) {
+    Operands op = operandsOf(inst);
+    int32_t c;
+    Mnemonic id = inst.entry->id;
+    if (id == Mnemonic::MUL) {
+        int other = op.rs1;
+        if (!constants.get(op.rs2, c)) {
+            if (!constants.get(op.rs1, c)) return false;
+            other = op.rs2;
+        }
+        if (c == 0) rewrite(inst, lines, "addi", op.rd, 0, 0, 0);
+        else if (c == 1) rewrite(inst, lines, "addi", op.rd, other, 0, 0);
+        else if (c == -1) rewrite(inst, lines, "sub", op.rd, 0, other, 0);
+        else if (c == 2) rewrite(inst, lines, "add", op.rd, other, other, 0);
+        else if (c > 0 && (c & (c - 1)) == 0) rewrite(inst, lines, "slli", op.rd, other, 0, __builtin_ctz(c));
+        else return false;
+        return true;
+    }
+    // Unsigned division by a power of two is a shift, the remainder a mask
+    if ((id == Mnemonic::DIVU || id == Mnemonic::REMU) && constants.get(op.rs2, c) && c > 0 && (c & (c - 1)) == 0) {
+        if (id == Mnemonic::DIVU) rewrite(inst, lines, "srli", op.rd, op.rs1, 0, __builtin_ctz(c));
+        else if (c <= 2048) rewrite(inst, lines, "andi", op.rd, op.rs1, 0, c - 1);
+        else return false;
+        return true;
+    }
+    if ((id != Mnemonic::DIV && id != Mnemonic::REM) || !constants.get(op.rs2, c) || (c != 1 && c != -1)) {
+        return false;
+    }
+    if (id == Mnemonic::REM) rewrite(inst, lines, "addi", op.rd, 0, 0, 0);
+    else if (c == 1) rewrite(inst, lines, "addi", op.rd, op.rs1, 0, 0);
+    else rewrite(inst, lines, "sub", op.rd, 0, op.rs1, 0);
+    return true;
+}
+
+// Fold the addi that last set a, in the block starting at first, into the
+// addi at text[last] ("addi a, a, j"). Returns the index of the folded
+// instruction, which can be deleted, or SIZE_MAX.
+static size_t foldAddi(vector<AssembledInstruction> &text, const vector<bool> &deleted, size_t first, size_t last, deque<string> &lines) {
+    Operands outer = operandsOf(text[last]);
+    if (text[last].entry->id != Mnemonic::ADDI || text[last].symbol >= 0 || outer.rd != outer.rs1 || outer.rd == 0) {
+        return SIZE_MAX;
+    }
+    int a = outer.rd;
+    for (size_t i = last; i-- > first;) {
+        if (deleted[i]) continue;
+        Operands op = operandsOf(text[i]);
+        if (writes(op, a)) {
+            if (text[i].entry->id != Mnemonic::ADDI || text[i].symbol >= 0) return SIZE_MAX;
+            // b must still hold its value at last
+            for (size_t k = i + 1; k < last; k++) {
+                if (!deleted[k] && op.rs1 != a && writes(operandsOf(text[k]), op.rs1)) return SIZE_MAX;
+            }
+            int32_t sum = op.imm + outer.imm;
+            if (sum < -2048 || sum > 2047) return SIZE_MAX;
+            rewrite(text[last], lines, "addi", a, op.rs1, 0, sum);
+            return i;
+        }
+        if (reads(op, a)) return SIZE_MAX;
+    }
+    return SIZE_MAX;
+}
+
+PeepholeReport optimizeText(vector<AssembledInstruction> &text, vector<LongInt> &textLabels, SymbolTable &symbols, deque<string> &lines) {
+    PeepholeReport report;
+    vector<bool> deleted(text.size(), false);
+
+    // Block starts: labels, numeric branch and jump targets, and the
+    // instruction after any control transfer
+    vector<bool> startsBlock(text.size() + 1, false);
+    for (LongInt label : textLabels) {
+        if (label % 4 == 0 && label / 4 < static_cast<LongInt>(startsBlock.size())) startsBlock[label / 4] = true;
+    }
+    for (size_t i = 0; i < text.size(); i++) {
+        if (!opaque(text[i])) continue;
+        startsBlock[i + 1] = true;
+        if (text[i].entry != nullptr && text[i].symbol < 0 && (text[i].entry->type == InstType::SB || text[i].entry->type == InstType::JAL)) {
+            LongInt target = text[i].address + isaImmediate(text[i].entry->type, text[i].word);
+            if (target >= 0 && target % 4 == 0 && target / 4 < static_cast<LongInt>(startsBlock.size())) startsBlock[target / 4] = true;
+        }
+    }
+
+    // An auipc that names no label reads its own address, which deleting
+    // anything before it would change
+    size_t firstMovable = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i].entry != nullptr && text[i].entry->type == InstType::AUIPC && text[i].symbol < 0) firstMovable = i + 1;
+    }
+
+    Constants constants;
+    constants.reset();
+    size_t blockStart = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (startsBlock[i]) {
+            constants.reset();
+            blockStart = i;
+        }
+        AssembledInstruction &inst = text[i];
+        if (opaque(inst)) {
+            constants.update(inst);
+            blockStart = i + 1;
+            continue;
+        }
+        if (i < firstMovable) {
+            // Rewrites in place still apply
+            if (reduce(inst, constants, lines)) report.reduced++;
+            constants.update(inst);
+            continue;
+        }
+        if (isNoOpMove(inst)) {
+            deleted[i] = true;
+            report.removed++;
+            continue;
+        }
+        if (reduce(inst, constants, lines)) {
+            report.reduced++;
+            if (isNoOpMove(inst)) {
+                deleted[i] = true;
+                report.removed++;
+                continue;
+            }
+        }
+        size_t folded = foldAddi(text, deleted, blockStart, i, lines);
+        if (folded != SIZE_MAX) {
+            deleted[folded] = true;
+            report.folded++;
+            // addi a, a, 1; addi a, a, -1 leaves nothing
+            if (isNoOpMove(inst)) {
+                deleted[i] = true;
+                report.removed++;
+                continue;
+            }
+        }
+        constants.update(inst);
+    }
+
+    if (report.removed + report.folded == 0) {
+        return report;
+    }
+
+    // New address of every old instruction address up to the end of the text
+    vector<LongInt> moved(text.size() + 1);
+    LongInt next = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        moved[i] = next;
+        if (!deleted[i]) next += 4;
+    }
+    moved[text.size()] = next;
+    auto relocated = [&](LongInt address) {
+        return (address >= 0 && address % 4 == 0 && address / 4 < static_cast<LongInt>(moved.size())) ? moved[address / 4] : address;
+    };
+
+    vector<AssembledInstruction> kept;
+    kept.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (deleted[i]) continue;
+        AssembledInstruction inst = move(text[i]);
+        // Numeric branch and jump offsets keep pointing at the same instruction
+        if (inst.entry != nullptr && inst.symbol < 0 && (inst.entry->type == InstType::SB || inst.entry->type == InstType::JAL)) {
+            LongInt target = relocated(inst.address + isaImmediate(inst.entry->type, inst.word));
+            relocateWord(RelocationType::Target, *inst.entry, inst.word, target, moved[i]);
+        }
+        inst.address = moved[i];
+        kept.push_back(move(inst));
+    }
+    text = move(kept);
+
+    for (LongInt &label : textLabels) {
+        label = relocated(label);
+    }
+    LongInt textEnd = static_cast<LongInt>(deleted.size()) * 4;
+    for (int id = 0; id < symbols.size(); id++) {
+        if (symbols[id].defined && symbols[id].value <= textEnd) symbols.define(id, relocated(symbols[id].value));
+    }
+    for (AssembledInstruction &inst : text) {
+        if (inst.entry != nullptr && inst.symbol >= 0 && symbols[inst.symbol].defined) {
+            patchInstruction(inst, symbols[inst.symbol]);
+        }
+    }
+    return report;
+}
@@ -0,0 +1,30 @@
+#include<vector>
+#include<deque>
+#include<process.h>
+
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+using namespace std;
+
+struct PeepholeReport {
+    size_t removed = 0;     // No-op moves deleted
+    size_t folded = 0;      // addi instructions merged into a later one
+    size_t reduced = 0;     // mul, div and rem replaced by cheaper instructions
+};
+
+// Simplify text within basic blocks:
+// - delete no-op moves (addi xN, xN, 0 and add/sub/or/xor/shifts by x0)
+// - fold "addi a, b, i; ... addi a, a, j" into "addi a, b, i+j" when
+//   nothing in between touches a or writes b
+// - replace mul by a register holding a known constant 0, 1, -1, 2 or
+//   2^k (given a register holding k) with addi, sub, add or sll, and div
+//   and rem by 1 or -1 with addi or sub. Division by other powers of two
+//   is kept: sra rounds toward minus infinity, div toward zero.
+// The text is then compacted: labels in symbols and textLabels move to
+// the new addresses, and label operands and numeric branch offsets are
+// encoded again. A label that is not defined yet is left to its fixup.
+// Rewritten lines get their assembly text from lines, which must outlive
+// the instructions.
+PeepholeReport optimizeText(vector<AssembledInstruction> &text, vector<LongInt> &textLabels, SymbolTable &symbols, deque<string> &lines);
+
+#endif
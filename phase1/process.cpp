@@ -4,584 +4,513 @@
 #include<map>
 #include<vector>
 #include<algorithm>
-#include<sstream>
 
 typedef long long LongInt;
 using namespace std;
 
-void processDataDirective(string line, LongInt memory[], LongInt &dataSize, LongInt MemoryStart, map<string, LongInt> &symbolTable) {
-    istringstream tokenizer(line);
-    string token, labelStr;
+static string quoted(string_view text) {
+    return "'" + string(text) + "'";
+}
+
+// Label names start with a letter or underscore
+static bool isLabelName(string_view token) {
+    return !token.empty() && (isalpha(static_cast<unsigned char>(token[0])) || token[0] == '_');
+}
+
+// Value of a data operand. A label name stands for its address; until a
+// forward label is defined the ASCII reading of parseValue() is kept.
+// Every label gets a fixup, so an object can relocate it.
+static LongInt dataValue(string_view token, DataSegment &data, int size, SymbolTable &symbols, vector<Fixup> &fixups) {
+    if (!isLabelName(token)) {
+        return parseValue(token);
+    }
+    int symbol = symbols.intern(token);
+    bool pending = !symbols[symbol].defined;
+    fixups.push_back({data.nextByte(), symbol, size, parseValue(token), pending});
+    return pending ? fixups.back().fallback : symbols[symbol].value;
+}
+
+void patchData(DataSegment &data, const Fixup &fixup, LongInt value) {
+    data.patch(fixup.index, value, fixup.size);
+}
+
+// Byte count or alignment of .space, .zero and .align, from 0 to limit
+static bool countOperand(LineTokens &tokens, LongInt limit, LongInt &count) {
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    count = isdigit(static_cast<unsigned char>(token.text[0])) ? parseValue(token.text) : -1;
+    if (count < 0 || count > limit) {
+        return tokens.fail(token, "invalid count " + quoted(token.text));
+    }
+    return true;
+}
+
+bool processDataDirective(LineTokens &tokens, DataSegment &data, LongInt MemoryStart, SymbolTable &symbols, vector<Fixup> &fixups) {
+    Token token;
     
-    // Extract label information
-    tokenizer >> token;
-    labelStr = token;
+    // Extract label information; directives such as .align may stand alone
+    if (!tokens.next(token)) return true;
+    if (token.text[0] != '.') {
+        string_view labelStr = token.text;
+
+        // Handle label format with colon
+        if (labelStr.back() == ':') {
+            labelStr.remove_suffix(1);
+        }
+        
+        // Register label in symbol table
+        symbols.define(symbols.intern(labelStr), MemoryStart + data.size());
+        
+        // Skip directive if label has no colon
+        if (token.text.back() != ':') {
+            tokens.next(token);
+        }
 
-    // Handle label format with colon
-    if (labelStr.back() == ':') {
-        labelStr = labelStr.substr(0, labelStr.size() - 1);
+        // Get the directive type
+        if (!tokens.next(token)) return true;
     }
     
-    // Register label in symbol table
-    symbolTable[labelStr] = MemoryStart + dataSize;
+    int size = 0;
+    if (token.text == ".byte") size = 1;
+    else if (token.text == ".half") size = 2;
+    else if (token.text == ".word") size = 4;
+    else if (token.text == ".dword") size = 8;
     
-    // Skip directive if label has no colon
-    if (token.back() != ':') {
-        tokenizer >> token;
-    }
-
-    // Get the directive type
-    tokenizer >> token;
+    // Addresses must stay within 32 bits
+    LongInt room = (1LL << 32) - MemoryStart - data.size();
     
-    // Process byte directive
-    if (token == ".byte") {
-        string valueToken;
-        while (tokenizer >> valueToken) {
-            if (valueToken != ",") {
-                memory[dataSize++] = parseValue(valueToken);
-            }
+    // Process byte, half-word, word and double-word directives
+    Token value;
+    if (size != 0) {
+        while (tokens.next(value)) {
+            data.store(dataValue(value.text, data, size, symbols, fixups), size);
         }
     }
-    // Process half-word directive
-    else if (token == ".half") {
-        string valueToken;
-        while (tokenizer >> valueToken) {
-            if (valueToken != ",") {
-                LongInt value = parseValue(valueToken);
-                
-                // Store 16-bit value as 2 bytes (little-endian)
-                for (int byteIndex = 0; byteIndex < 2; byteIndex++) {
-                    memory[dataSize++] = value & 0xFF;
-                    value >>= 8;
-                }
+    // Process null-terminated string directive
+    else if (token.text == ".asciiz") {
+        while (tokens.next(value)) {
+            // Skip the quotes and store each character
+            for (size_t charIndex = 1; charIndex + 1 < value.text.size(); charIndex++) {
+                data.store(value.text[charIndex], 1);
             }
         }
     }
-    // Process word directive
-    else if (token == ".word") {
-        string valueToken;
-        while (tokenizer >> valueToken) {
-            if (valueToken != ",") {
-                LongInt value = parseValue(valueToken);
-                
-                // Store 32-bit value as 4 bytes (little-endian)
-                for (int i = 0; i < 4; i++) {
-                    memory[dataSize++] = value & 0xFF;
-                    value >>= 8;
-                }
-            }
+    // Reserve zeroed bytes: .zero count, .space count[, fill]
+    else if (token.text == ".space" || token.text == ".zero") {
+        LongInt count;
+        if (!countOperand(tokens, room, count)) {
+            return false;
+        }
+        LongInt fill = 0;
+        if (token.text == ".space" && tokens.next(value)) {
+            fill = parseValue(value.text);
         }
+        data.fill(count, fill & 0xFF);
     }
-    // Process double-word directive
-    else if (token == ".dword") {
-        string valueToken;
-        while (tokenizer >> valueToken) {
-            if (valueToken != ",") {
-                LongInt value = parseValue(valueToken);
-                
-                // Store 64-bit value as 8 bytes (little-endian)
-                for (int byteIndex = 0; byteIndex < 8; byteIndex++) {
-                    memory[dataSize++] = value & 0xFF;
-                    value >>= 8;
-                }
-            }
+    // Align the next byte to 2^n
+    else if (token.text == ".align") {
+        LongInt exponent;
+        if (!countOperand(tokens, 20, exponent)) {
+            return false;
         }
+        data.align(MemoryStart, 1LL << exponent);
     }
-    // Process null-terminated string directive
-    else if (token == ".asciiz") {
-        string valueToken;
-        while (tokenizer >> valueToken) {
-            if (valueToken != ",") {
-                // Skip the quotes and store each character
-                for (size_t charIndex = 1; charIndex < valueToken.size() - 1; charIndex++) {
-                    memory[dataSize++] = static_cast<LongInt>(valueToken[charIndex]);
-                }
-            }
+    return true;
+}
+
+// Register operand
+static bool registerOperand(LineTokens &tokens, int &number) {
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    number = encodeRegister(token.text);
+    if (number < 0) {
+        return tokens.fail(token, "invalid register " + quoted(token.text));
+    }
+    return true;
+}
+
+// 12-bit signed immediate, or the offset part of a memory operand
+static bool immediateOperand(LineTokens &tokens, const Token &token, string_view text, int32_t &imm) {
+    if (!encodeImmediate(text, imm)) {
+        return tokens.fail(token, "immediate " + quoted(text) + " is not a 12-bit signed value");
+    }
+    return true;
+}
+
+// Operator and label of %hi(label), %lo(label), %pcrel_hi(label) or
+// %pcrel_lo(label); false if text is not one of them
+static bool relocationOperator(string_view text, RelocationType &type, string_view &label) {
+    static const pair<string_view, RelocationType> operators[] = {
+        {"%hi(", RelocationType::Hi},
+        {"%lo(", RelocationType::Lo},
+        {"%pcrel_hi(", RelocationType::PcrelHi},
+        {"%pcrel_lo(", RelocationType::PcrelLo},
+    };
+    for (const auto &op : operators) {
+        if (text.size() > op.first.size() + 1 && text.compare(0, op.first.size(), op.first) == 0 && text.back() == ')') {
+            type = op.second;
+            label = text.substr(op.first.size(), text.size() - op.first.size() - 1);
+            return true;
         }
     }
+    return false;
 }
 
-void processRType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                 vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                 LongInt instructionPointer, unordered_map<string, string> &registerMap) {
-    // Initialize fields array for R-type instruction components
-    vector<string> fields(6, "");
-    string binaryEncoding;
-    
-    // Parse instruction components
-    istringstream tokenizer(instruction);
-    string token, opcode;
-    
-    // Get operation code
-    tokenizer >> opcode;
-    
-    // Set opcode field
-    fields[0] = determineOpcode(opcode, fields[0]);
-    
-    // Extract destination register
-    tokenizer >> token;
-    fields[1] = encodeRegister(token, fields[1], registerMap);
-    
-    // Extract first source register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[3] = encodeRegister(token, fields[3], registerMap);
-    
-    // Extract second source register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[4] = encodeRegister(token, fields[4], registerMap);
-    
-    // Determine function codes
-    fields[5] = determineFunct7(opcode, fields[5]);
-    fields[2] = determineFunct3(opcode, fields[2]);
-    
-    // Construct binary encoding
-    for (int fieldIndex = 5; fieldIndex >= 0; fieldIndex--) {
-        if (fields[fieldIndex] == "error") {
-            binaryInstructions.push_back("error");
-            return;
+// Encode the label operand of inst, whose word holds everything else. A
+// label that is not defined yet is left pending with defer and is an
+// error without.
+static bool labelOperand(LineTokens &tokens, const Token &token, string_view label, RelocationType type, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int symbol = symbols.find(label);
+    inst.column = token.column;
+    inst.relocation = type;
+    if (symbol >= 0 && symbols[symbol].defined) {
+        inst.symbol = symbol;
+        const char *problem = relocateWord(type, *inst.entry, inst.word, symbols[symbol].value, inst.address);
+        return problem == nullptr || tokens.fail(token, problem + (" " + quoted(label)));
+    }
+    if (!defer) {
+        return tokens.fail(token, "undefined label " + quoted(label));
+    }
+    inst.symbol = symbols.intern(label);
+    inst.pending = true;
+    return true;
+}
+
+// Immediate of an I-type, load or store instruction, whose word holds the
+// registers: a 12-bit number, %lo(label) or %pcrel_lo(label)
+static bool lowOperand(LineTokens &tokens, const Token &token, string_view text, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    RelocationType type;
+    string_view label;
+    if (relocationOperator(text, type, label)) {
+        if (type != RelocationType::Lo && type != RelocationType::PcrelLo) {
+            return tokens.fail(token, "expected %lo or %pcrel_lo, got " + quoted(text));
         }
-        binaryEncoding += fields[fieldIndex];
+        return labelOperand(tokens, token, label, type, inst, symbols, defer);
     }
-    
-    // Store results
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Construct decoded representation
-    string decoded = fields[0] + "-" + fields[2] + "-" + fields[5] + "-" + 
-                    fields[1] + "-" + fields[3] + "-" + fields[4] + "-" + "NULL";
-    
-    // Save instruction information
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    int32_t imm;
+    if (!immediateOperand(tokens, token, text, imm)) {
+        return false;
+    }
+    inst.word = isaEncode(*inst.entry, rdField(inst.word), rs1Field(inst.word), rs2Field(inst.word), imm);
+    return true;
 }
 
-void processIType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                 vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                 LongInt instructionPointer, unordered_map<string, string> &registerMap) {
-    // Parse the I-type instruction
-    istringstream tokenizer(instruction);
-    string token, opcode;
-    
-    // Extract operation
-    tokenizer >> opcode;
-    
-    // Initialize fields for I-type format
-    vector<string> fields(5, "");
-    fields[0] = determineOpcode(opcode, fields[0]);
+// offset(register) operand of a load or store; the offset is left in
+// text. It may be %lo(label), whose parentheses come first.
+static bool memoryOperand(LineTokens &tokens, Token &token, int &base, string_view &offset) {
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    string_view text = token.text;
+    size_t openParenPos = text[0] == '%' ? text.find('(', text.find(')')) : text.find('(');
+    if (openParenPos == string_view::npos) {
+        return tokens.fail(token, "expected offset(register), got " + quoted(text));
+    }
     
-    // Get destination register
-    tokenizer >> token;
-    fields[1] = encodeRegister(token, fields[1], registerMap);
+    // Register runs to the closing parenthesis
+    size_t closeParenPos = text.find(')', openParenPos);
+    string_view reg = text.substr(openParenPos + 1, closeParenPos - openParenPos - 1);
+    base = encodeRegister(reg);
+    if (base < 0) {
+        return tokens.fail({reg, token.column + static_cast<int>(openParenPos) + 1}, "invalid register " + quoted(reg));
+    }
+    offset = text.substr(0, openParenPos);
+    return true;
+}
+
+bool processRType(LineTokens &tokens, AssembledInstruction &inst) {
+    int rd, rs1, rs2;
+    if (!registerOperand(tokens, rd) || !registerOperand(tokens, rs1) || !registerOperand(tokens, rs2)) {
+        return false;
+    }
     
-    // Get source register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[3] = encodeRegister(token, fields[3], registerMap);
+    // Opcode, funct3 and funct7 come from the ISA table
+    inst.word = isaEncode(*inst.entry, rd, rs1, rs2, 0);
+    return true;
+}
+
+bool processIType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rd, rs1;
+    if (!registerOperand(tokens, rd) || !registerOperand(tokens, rs1)) {
+        return false;
+    }
     
     // Get immediate value
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[4] = encodeImmediate(token, fields[4]);
-    
-    // Set function code
-    fields[2] = determineFunct3(opcode, fields[2]);
-    
-    // Build binary encoding
-    string binaryEncoding;
-    bool hasError = false;
-    
-    for (int i = 4; i >= 0; i--) {
-        if (fields[i] == "error") {
-            hasError = true;
-            break;
-        }
-        binaryEncoding += fields[i];
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
     }
     
-    if (hasError) {
-        binaryInstructions.push_back("error");
-        return;
+    // slli, srli and srai share the immediate with funct7: a plain 5-bit shift amount
+    if (isaShiftImmediate(*inst.entry)) {
+        int32_t shamt;
+        if (!isdigit(static_cast<unsigned char>(token.text[0])) || !encodeImmediate(token.text, shamt) || shamt > 31) {
+            return tokens.fail(token, "shift amount " + quoted(token.text) + " is not in 0..31");
+        }
+        inst.word = isaEncode(*inst.entry, rd, rs1, 0, shamt);
+        return true;
     }
     
-    // Store results
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Create decoded representation
-    string decoded = fields[0] + "-" + fields[2] + "-" + "NULL" + "-" + 
-                    fields[1] + "-" + fields[3] + "-" + "NULL" + "-" + fields[4];
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    inst.word = isaEncode(*inst.entry, rd, rs1, 0, 0);
+    return lowOperand(tokens, token, token.text, inst, symbols, defer);
 }
 
-void processLoadType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                    vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                    LongInt instructionPointer, unordered_map<string, string> &registerMap) {
-    // Initialize components
-    vector<string> fields(6, "");
-    istringstream tokenizer(instruction);
-    string token, opcode;
-    
-    // Get opcode
-    tokenizer >> opcode;
-    fields[0] = determineOpcode(opcode, fields[0]);
-    
-    // Get destination register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[1] = encodeRegister(token, fields[1], registerMap);
-    
-    // Set function code
-    fields[2] = determineFunct3(opcode, fields[2]);
-    
-    // Get memory address expression
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    
-    // Parse offset(register) format
-    string offset, reg;
-    size_t openParenPos = token.find('(');
-    offset = token.substr(0, openParenPos);
-    
-    // Extract register between parentheses
-    size_t closeParenPos = token.find(')');
-    reg = token.substr(openParenPos + 1, closeParenPos - openParenPos - 1);
-    
-    // Encode base register and offset
-    fields[3] = encodeRegister(reg, fields[3], registerMap);
-    fields[4] = encodeImmediate(offset, fields[4]);
-    
-    // Construct binary encoding
-    string binaryEncoding;
-    for (int i = 4; i >= 0; i--) {
-        if (fields[i] == "error") {
-            binaryInstructions.push_back("error");
-            return;
+// Predecessor or successor set of fence: some of i, o, r and w, in that
+// order, for device input and output and memory reads and writes
+static bool fenceSet(LineTokens &tokens, uint32_t &set) {
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    static const char order[] = "iorw";
+    set = 0;
+    size_t next = 0;
+    for (char c : token.text) {
+        size_t bit = string_view(order).find(c, next);
+        if (bit == string_view::npos) {
+            return tokens.fail(token, "expected a fence set of i, o, r and w, got " + quoted(token.text));
         }
-        binaryEncoding += fields[i];
+        set |= 8 >> bit;
+        next = bit + 1;
     }
-    
-    // Save instruction information
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Create decoded representation
-    string decoded = fields[0] + "-" + fields[2] + "-" + "NULL" + "-" + 
-                    fields[1] + "-" + fields[3] + "-" + "NULL" + "-" + fields[4];
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    return true;
 }
 
-void processStoreType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                     vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                     LongInt instructionPointer, unordered_map<string, string> &registerMap) {
-    // Setup instruction components
-    vector<string> fields(6, "");
-    string token, opcode;
-    istringstream tokenizer(instruction);
-    
-    // Get operation
-    tokenizer >> opcode;
-    
-    // Set opcode and function fields
-    fields[0] = determineOpcode(opcode, fields[0]);
-    fields[2] = determineFunct3(opcode, fields[2]);
-    
-    // Get source register (value to store)
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[4] = encodeRegister(token, fields[4], registerMap);
-    
-    // Get memory address expression
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    
-    // Extract offset and base register
-    string offset, reg;
-    size_t idx = 0;
-    
-    // Find opening parenthesis
-    while (idx < token.size() && token[idx] != '(') {
-        offset += token[idx++];
+bool processSystemType(LineTokens &tokens, AssembledInstruction &inst) {
+    if (inst.entry->id != Mnemonic::FENCE) {
+        inst.word = inst.entry->match;
+        return true;
     }
     
-    // Skip opening parenthesis
-    idx++;
-    
-    // Extract register name
-    while (idx < token.size() && token[idx] != ')') {
-        reg += token[idx++];
+    // fence alone orders everything, as fence iorw, iorw
+    uint32_t predecessor = 0xF, successor = 0xF;
+    if (tokens.position < tokens.tokens.size() && (!fenceSet(tokens, predecessor) || !fenceSet(tokens, successor))) {
+        return false;
     }
-    
-    // Encode base register and offset
-    fields[3] = encodeRegister(reg, fields[3], registerMap);
-    fields[5] = encodeImmediate(offset, fields[5]);
-    
-    // Handle S-type immediate split (7+5 bits)
-    string immediateBits = fields[5];
-    fields[5] = immediateBits.substr(0, 7); // Upper 7 bits
-    fields[1] = immediateBits.substr(7, 5); // Lower 5 bits
-    
-    // Construct binary encoding
-    string binaryEncoding;
-    bool hasError = false;
-    
-    for (int i = 5; i >= 0; i--) {
-        if (fields[i] == "error") {
-            hasError = true;
-            break;
-        }
-        binaryEncoding += fields[i];
+    inst.word = isaEncode(*inst.entry, 0, 0, 0, static_cast<int32_t>(predecessor << 4 | successor));
+    return true;
+}
+
+bool processLoadType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rd, rs1;
+    Token token;
+    string_view offset;
+    if (!registerOperand(tokens, rd) || !memoryOperand(tokens, token, rs1, offset)) {
+        return false;
     }
     
-    if (hasError) {
-        binaryInstructions.push_back("error");
-        return;
+    inst.word = isaEncode(*inst.entry, rd, rs1, 0, 0);
+    return lowOperand(tokens, token, offset, inst, symbols, defer);
+}
+
+bool processStoreType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rs2, rs1;
+    Token token;
+    string_view offset;
+    if (!registerOperand(tokens, rs2) || !memoryOperand(tokens, token, rs1, offset)) {
+        return false;
     }
     
-    // Store instruction information
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Create decoded representation
-    string fullImmediate = fields[5] + fields[1];
-    string decoded = fields[0] + "-" + fields[2] + "-" + "NULL" + "-" + 
-                    "NULL" + "-" + fields[3] + "-" + fields[4] + "-" + fullImmediate;
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    // isaEncode splits the immediate into imm[11:5] and imm[4:0]
+    inst.word = isaEncode(*inst.entry, 0, rs1, rs2, 0);
+    return lowOperand(tokens, token, offset, inst, symbols, defer);
 }
 
-void processBranchType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                      vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                      LongInt instructionPointer, map<string, LongInt> &symbolTable, 
-                      unordered_map<string, string> &registerMap) {
-    // Initialize fields for branch instruction
-    vector<string> fields(6, "");
-    string token, opcode;
-    istringstream tokenizer(instruction);
-    
-    // Extract operation
-    tokenizer >> opcode;
-    
-    // Set opcode and function code
-    fields[0] = determineOpcode(opcode, fields[0]);
-    fields[2] = determineFunct3(opcode, fields[2]);
-    
-    // Get first source register
-    tokenizer >> token;
-    fields[3] = encodeRegister(token, fields[3], registerMap);
-    
-    // Get second source register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[4] = encodeRegister(token, fields[4], registerMap);
-    
-    // Get branch target
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    
-    // Check if target is valid
-    bool isNumericTarget = all_of(token.begin(), token.end(), ::isdigit);
-    bool isSymbolTarget = symbolTable.find(token) != symbolTable.end();
-    
-    if (!isNumericTarget && !isSymbolTarget) {
-        binaryInstructions.push_back("error");
-        return;
+// Put a branch or jal byte offset into an encoded word. Returns the
+// problem if the offset is not word aligned or, for a branch, does not
+// fit in 13 bits.
+static const char *encodeTarget(const IsaEntry &entry, LongInt immediate, uint32_t &word) {
+    if (immediate % 4 != 0) {
+        return "misaligned target";
     }
-    
-    // Calculate branch offset
+    int32_t imm = static_cast<int32_t>(immediate);
+    if (entry.type == InstType::SB && !encodeBranchImmediate(immediate, imm)) {
+        return "branch target out of range";
+    }
+    // UJ-type format has a 21-bit signed offset
+    if (entry.type == InstType::JAL && (immediate < -(1LL << 20) || immediate >= (1LL << 20))) {
+        return "jump target out of range";
+    }
+    word = isaEncode(entry, rdField(word), rs1Field(word), rs2Field(word), imm);
+    return nullptr;
+}
+
+const char *relocateWord(RelocationType type, const IsaEntry &entry, uint32_t &word, LongInt value, LongInt address) {
     LongInt immediate;
-    if (isSymbolTarget) {
-        immediate = symbolTable[token] - instructionPointer;
-    } else {
-        immediate = stoi(token);
+    switch (type) {
+    case RelocationType::Target:
+        return encodeTarget(entry, value - address, word);
+    case RelocationType::Hi:
+        immediate = (value + 0x800) >> 12;
+        break;
+    case RelocationType::PcrelHi:
+        immediate = (value - address + 0x800) >> 12;
+        break;
+    case RelocationType::Lo:
+        immediate = value;
+        break;
+    case RelocationType::PcrelLo:
+        immediate = value - (address - 4);
+        break;
+    default:
+        return "not an instruction relocation";
     }
-    
-    // Verify 4-byte alignment
-    if (immediate % 4 != 0) {
-        binaryInstructions.push_back("error");
-        return;
+    // isaEncode keeps the 20 or 12 bits the instruction has room for
+    word = isaEncode(entry, rdField(word), rs1Field(word), rs2Field(word), static_cast<int32_t>(immediate));
+    return nullptr;
+}
+
+// Encode a numeric offset or a label; a defined label takes precedence
+// over a number
+static bool targetOperand(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
     }
-    
-    // Encode branch immediate
-    string offsetStr = to_string(immediate);
-    fields[5] = encodeBranchImmediate(offsetStr, fields[5]);
-    
-    // Rearrange immediate bits for SB-type format
-    string immediateEncoding = fields[5];
-    
-    // Format: imm[12|10:5] rs2 rs1 funct3 imm[4:1|11] opcode
-    fields[5] = immediateEncoding.substr(0, 1);          // imm[12]
-    fields[5] += immediateEncoding.substr(2, 6);         // imm[10:5]
-    
-    fields[1] = immediateEncoding.substr(8, 4);          // imm[4:1]
-    fields[1] += immediateEncoding.substr(1, 1);         // imm[11]
-    
-    // Construct binary encoding
-    string binaryEncoding;
-    for (int i = 5; i >= 0; i--) {
-        if (fields[i] == "error") {
-            binaryInstructions.push_back("error");
-            return;
-        }
-        binaryEncoding += fields[i];
+    string_view text = token.text;
+    bool isNumericTarget = all_of(text.begin(), text.end(), ::isdigit);
+    int symbol = symbols.find(text);
+    if (!isNumericTarget || (symbol >= 0 && symbols[symbol].defined)) {
+        return labelOperand(tokens, token, text, RelocationType::Target, inst, symbols, defer);
     }
     
-    // Store instruction information
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Construct full immediate for decoded form
-    string fullImmediate = fields[5].substr(0, 1) + fields[1].substr(4, 1) + 
-                           fields[5].substr(1) + fields[1].substr(0, 4);
-                           
-    // Create decoded representation
-    string decoded = fields[0] + "-" + fields[2] + "-" + "NULL" + "-" + 
-                    "NULL" + "-" + fields[3] + "-" + fields[4] + "-" + fullImmediate;
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    inst.column = token.column;
+    int32_t offset;
+    auto parsed = from_chars(text.data(), text.data() + text.size(), offset);
+    const char *problem = (parsed.ec == errc()) ? encodeTarget(*inst.entry, offset, inst.word) : "target out of range";
+    if (problem != nullptr) {
+        return tokens.fail(token, problem + (" " + quoted(text)));
+    }
+    return true;
 }
 
-void processUpperImmediate(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                          vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                          LongInt instructionPointer, unordered_map<string, string> &registerMap) {
-    // U-type instruction handling (LUI, AUIPC)
-    vector<string> fields(3, "");
-    string token, opcode;
-    istringstream tokenizer(instruction);
-    
-    // Extract operation
-    tokenizer >> opcode;
-    fields[0] = determineOpcode(opcode, fields[0]);
-    
-    // Get destination register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[1] = encodeRegister(token, fields[1], registerMap);
-    
-    // Get upper immediate value
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[2] = encodeUpperImmediate(token, fields[2]);
-    
-    // Construct binary encoding
-    string binaryEncoding;
-    bool hasError = false;
-    
-    for (int i = 2; i >= 0; i--) {
-        if (fields[i] == "error") {
-            hasError = true;
-            break;
-        }
-        binaryEncoding += fields[i];
+bool patchInstruction(AssembledInstruction &inst, const Symbol &label) {
+    const char *problem = "undefined label";
+    if (label.defined) {
+        problem = relocateWord(inst.relocation, *inst.entry, inst.word, label.value, inst.address);
     }
-    
-    if (hasError) {
-        binaryInstructions.push_back("error");
-        return;
+    if (problem != nullptr) {
+        inst.entry = nullptr;
+        inst.error = problem + (" " + quoted(label.name));
+        return false;
     }
-    
-    // Store instruction information
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Create decoded representation
-    string decoded = fields[0] + "-" + "NULL" + "-" + "NULL" + "-" + 
-                    fields[1] + "-" + "NULL" + "-" + "NULL" + "-" + fields[2];
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
+    return true;
 }
 
-void processJumpType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, 
-                    vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, 
-                    LongInt instructionPointer, map<string, LongInt> &symbolTable, 
-                    unordered_map<string, string> &registerMap) {
-    // Process JAL/JALR instructions
-    vector<string> fields(3, "");
-    string token, opcode;
-    istringstream tokenizer(instruction);
-    
-    // Extract operation
-    tokenizer >> opcode;
-    fields[0] = determineOpcode(opcode, fields[0]);
-    
-    // Get destination register
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    fields[1] = encodeRegister(token, fields[1], registerMap);
-    
-    // Get jump target
-    tokenizer >> token;
-    if (token == ",") tokenizer >> token;
-    
-    // Validate jump target
-    bool isNumericTarget = all_of(token.begin(), token.end(), ::isdigit);
-    bool isSymbolTarget = symbolTable.find(token) != symbolTable.end();
-    
-    if (!isNumericTarget && !isSymbolTarget) {
-        binaryInstructions.push_back("error");
-        return;
+bool processBranchType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rs1, rs2;
+    if (!registerOperand(tokens, rs1) || !registerOperand(tokens, rs2)) {
+        return false;
     }
     
-    // Calculate jump offset
-    LongInt immediate;
-    if (isSymbolTarget) {
-        immediate = symbolTable[token] - instructionPointer;
-    } else {
-        immediate = stoi(token);
+    // Format: imm[12|10:5] rs2 rs1 funct3 imm[4:1|11] opcode
+    inst.word = isaEncode(*inst.entry, 0, rs1, rs2, 0);
+    return targetOperand(tokens, inst, symbols, defer);
+}
+
+bool processUpperImmediate(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rd;
+    if (!registerOperand(tokens, rd)) {
+        return false;
     }
     
-    // Verify 4-byte alignment
-    if (immediate % 4 != 0) {
-        binaryInstructions.push_back("error");
-        return;
+    // Get upper immediate value: a number, %hi(label) with lui or
+    // %pcrel_hi(label) with auipc
+    Token token;
+    int32_t imm;
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    RelocationType type;
+    string_view label;
+    if (relocationOperator(token.text, type, label)) {
+        RelocationType expected = inst.entry->type == InstType::LUI ? RelocationType::Hi : RelocationType::PcrelHi;
+        if (type != expected) {
+            return tokens.fail(token, string(expected == RelocationType::Hi ? "expected %hi" : "expected %pcrel_hi") + ", got " + quoted(token.text));
+        }
+        inst.word = isaEncode(*inst.entry, rd, 0, 0, 0);
+        return labelOperand(tokens, token, label, type, inst, symbols, defer);
+    }
+    if (!encodeUpperImmediate(token.text, imm)) {
+        return tokens.fail(token, "immediate " + quoted(token.text) + " is not a 20-bit value");
     }
     
-    // Generate 20-bit jump target encoding
-    string immediateBits;
-    for (int i = 20; i >= 1; i--) {
-        immediateBits += ((immediate & (1LL << i)) ? '1' : '0');
+    inst.word = isaEncode(*inst.entry, rd, 0, 0, imm);
+    return true;
+}
+
+bool processJumpType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer) {
+    int rd;
+    if (!registerOperand(tokens, rd)) {
+        return false;
     }
     
     // UJ-type format: imm[20|10:1|11|19:12] rd opcode
-    // Reorder immediate bits per format specification
-    fields[2] = immediateBits.substr(0, 1);          // imm[20]
-    fields[2] += immediateBits.substr(10, 10);       // imm[10:1]
-    fields[2] += immediateBits.substr(9, 1);         // imm[11]
-    fields[2] += immediateBits.substr(1, 8);         // imm[19:12]
-    
-    // Construct binary encoding
-    string binaryEncoding;
-    for (int i = 2; i >= 0; i--) {
-        if (fields[i] == "error") {
-            binaryInstructions.push_back("error");
-            return;
+    inst.word = isaEncode(*inst.entry, rd, 0, 0, 0);
+    return targetOperand(tokens, inst, symbols, defer);
+}
+
+// Append a field value as a fixed-width binary string
+static void appendBits(string &out, uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; i--) {
+        out += ((value >> i) & 1) ? '1' : '0';
+    }
+}
+
+// Append the decoded fields of an encoded instruction in the order
+// opcode-funct3-funct7-rd-rs1-rs2-immediate, with NULL for unused fields
+void decodeFields(string &decoded, const IsaEntry &entry, uint32_t word) {
+    OperandLayout layout = entry.layout;
+    bool hasFunct3 = layout != OperandLayout::RdUpper && layout != OperandLayout::RdTarget;
+    appendBits(decoded, word & 0x7F, 7);
+    decoded += '-';
+    if (hasFunct3) appendBits(decoded, (word >> 12) & 0x7, 3);
+    else decoded += "NULL";
+    decoded += '-';
+    if (layout == OperandLayout::RdRs1Rs2 || isaShiftImmediate(entry)) appendBits(decoded, word >> 25, 7);
+    else decoded += "NULL";
+    decoded += '-';
+    if (layoutWritesRd(layout)) appendBits(decoded, rdField(word), 5);
+    else decoded += "NULL";
+    decoded += '-';
+    if (layoutReadsRs1(layout)) appendBits(decoded, rs1Field(word), 5);
+    else decoded += "NULL";
+    decoded += '-';
+    if (layoutReadsRs2(layout)) appendBits(decoded, rs2Field(word), 5);
+    else decoded += "NULL";
+    decoded += '-';
+    
+    // Branch and jump offsets drop bit 0; U-type shows the raw 20-bit field,
+    // shifts by immediate the 5-bit amount after funct7
+    int32_t imm = isaImmediate(entry.type, word);
+    switch (layout) {
+    case OperandLayout::RdRs1Rs2:
+        decoded += "NULL";
+        break;
+    case OperandLayout::RdRs1Imm:
+        if (isaShiftImmediate(entry)) {
+            appendBits(decoded, imm, 5);
+            break;
         }
-        binaryEncoding += fields[i];
+        appendBits(decoded, imm, 12);
+        break;
+    case OperandLayout::None:
+    case OperandLayout::RdMem:
+    case OperandLayout::Rs2Mem:
+        appendBits(decoded, imm, 12);
+        break;
+    case OperandLayout::Rs1Rs2Target:
+        appendBits(decoded, imm >> 1, 12);
+        break;
+    case OperandLayout::RdUpper:
+        appendBits(decoded, word >> 12, 20);
+        break;
+    case OperandLayout::RdTarget:
+        appendBits(decoded, imm >> 1, 20);
+        break;
     }
-    
-    // Store instruction information
-    binaryInstructions.push_back(binaryEncoding);
-    
-    // Restore original bit ordering for decoded form
-    string fullImmediate = fields[2].substr(0, 1) + 
-                           fields[2].substr(12) + 
-                           fields[2].substr(11, 1) + 
-                           fields[2].substr(1, 10);
-                           
-    // Create decoded representation
-    string decoded = fields[0] + "-" + "NULL" + "-" + "NULL" + "-" + 
-                    fields[1] + "-" + "NULL" + "-" + "NULL" + "-" + fullImmediate;
-                    
-    decodedInstructions.push_back(decoded);
-    assemblyLines.push_back(instruction);
-    instructionAddresses.push_back(instructionPointer);
 }
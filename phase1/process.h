@@ -1,19 +1,73 @@
 #include<iostream>
 #include<string>
 #include<bits/stdc++.h>
+#include "../phase3/isa.h"
+#include<lexer.h>
+#include<symbols.h>
+#include<dataSegment.h>
 
 #ifndef PROCESS_H
 #define PROCESS_H
 typedef long long LongInt;
 using namespace std;
 
+// How the address of a label goes into an instruction or data value
+enum class RelocationType {
+    Target,     // Branch or jal: offset from the instruction
+    Hi,         // %hi(label) in lui: upper 20 bits, rounded to pair with %lo
+    Lo,         // %lo(label): low 12 bits, sign-extended
+    PcrelHi,    // %pcrel_hi(label) in auipc: upper 20 bits of the offset
+    PcrelLo,    // %pcrel_lo(label): low 12 bits of the offset from the auipc just before
+    Data        // .byte, .half, .word or .dword naming the label
+};
+
+// One line of the text segment after encoding
+struct AssembledInstruction {
+    LongInt address;
+    const IsaEntry *entry;   // nullptr if the line failed to encode
+    uint32_t word;
+    string_view assembly;    // Source line
+    int line;
+    int column;              // Offending operand, or the label of a pending target
+    string error;            // Why the line failed to encode
+    int symbol = -1;         // Interned label operand, -1 if the line names none
+    RelocationType relocation = RelocationType::Target;
+    bool pending = false;    // The label was not defined yet and is missing from word
+};
+
+// Label reference in the text or data segment
+struct Fixup {
+    size_t index;       // Entry of the text segment, or DataSegment::nextByte() of the value
+    int symbol;         // Interned label
+    int size;           // Data bytes to patch; 0 in the text segment
+    LongInt fallback;   // Data value kept if the label is never defined
+    bool pending;       // The label was not defined when the line was read
+};
+
 #endif
 
-void processDataDirective(string line, LongInt memory[], LongInt &dataSize, LongInt MemoryStart, map<string, LongInt> &symbolTable);
-void processRType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, unordered_map<string, string> &registerMap);
-void processIType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, unordered_map<string, string> &registerMap);
-void processLoadType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, unordered_map<string, string> &registerMap);
-void processStoreType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, unordered_map<string, string> &registerMap);
-void processBranchType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, map<string, LongInt> &symbolTable, unordered_map<string, string> &registerMap);
-void processUpperImmediate(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, unordered_map<string, string> &registerMap);
-void processJumpType(string instruction, vector<string> &binaryInstructions, vector<string> &decodedInstructions, vector<string> &assemblyLines, vector<LongInt> &instructionAddresses, LongInt instructionPointer, map<string, LongInt> &symbolTable, unordered_map<string, string> &registerMap);
+// The process*Type functions read the operands after the mnemonic and
+// encode inst.word from inst.entry. On failure they return false with the
+// reason in tokens.error. A label operand (a branch or jal target, or
+// %hi, %lo, %pcrel_hi or %pcrel_lo) is kept in inst.symbol. With defer a
+// label that is not defined yet is left pending for patchInstruction();
+// without it every label must already be defined, and symbols is only
+// read, so lines can be encoded on several threads.
+// processDataDirective likewise fails on a bad .space, .zero or .align,
+// and adds a fixup for every label named by a data value.
+bool processDataDirective(LineTokens &tokens, DataSegment &data, LongInt MemoryStart, SymbolTable &symbols, vector<Fixup> &fixups);
+bool processRType(LineTokens &tokens, AssembledInstruction &inst);
+bool processIType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+bool processLoadType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+bool processStoreType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+bool processBranchType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+bool processUpperImmediate(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+bool processJumpType(LineTokens &tokens, AssembledInstruction &inst, SymbolTable &symbols, bool defer);
+// fence with optional predecessor and successor sets, ecall and ebreak
+bool processSystemType(LineTokens &tokens, AssembledInstruction &inst);
+bool patchInstruction(AssembledInstruction &inst, const Symbol &label);
+// Put the address value of a label into the word of the instruction at
+// address; returns the problem if it does not fit
+const char *relocateWord(RelocationType type, const IsaEntry &entry, uint32_t &word, LongInt value, LongInt address);
+void patchData(DataSegment &data, const Fixup &fixup, LongInt value);
+void decodeFields(string &decoded, const IsaEntry &entry, uint32_t word);
@@ -0,0 +1,184 @@
+#include<pseudo.h>
+#include<assign.h>
+#include<encode.h>
+#include<algorithm>
+#include<charconv>
+
+using namespace std;
+
+// Offsets jal reaches, in bytes from the jal
+const LongInt JAL_MIN = -(1LL << 20);
+const LongInt JAL_MAX = (1LL << 20) - 2;
+
+bool findPseudo(string_view mnemonic, PseudoKind &kind) {
+    static const pair<string_view, PseudoKind> pseudos[] = {
+        {"nop", PseudoKind::Nop},
+        {"mv", PseudoKind::Mv},
+        {"ret", PseudoKind::Ret},
+        {"li", PseudoKind::Li},
+        {"la", PseudoKind::La},
+        {"j", PseudoKind::J},
+        {"call", PseudoKind::Call},
+    };
+    for (const auto &pseudo : pseudos) {
+        if (pseudo.first == mnemonic) {
+            kind = pseudo.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool registerOperand(LineTokens &tokens, int &number) {
+    Token token;
+    if (!tokens.operand(token)) {
+        return false;
+    }
+    number = encodeRegister(token.text);
+    return number >= 0 || tokens.fail(token, "invalid register '" + string(token.text) + "'");
+}
+
+// Label names start with a letter or underscore
+static bool labelName(LineTokens &tokens, const Token &token, string_view &label) {
+    label = token.text;
+    return isalpha(static_cast<unsigned char>(label[0])) || label[0] == '_' || tokens.fail(token, "expected a label, got '" + string(label) + "'");
+}
+
+static bool labelOperand(LineTokens &tokens, string_view &label) {
+    Token token;
+    return tokens.operand(token) && labelName(tokens, token, label);
+}
+
+// Constant of li: a number as parseValue reads it, except that decimal
+// and hex values take the whole 32-bit range, which parseValue cuts at
+// INT_MAX
+static LongInt constantValue(string_view text) {
+    bool hex = text.size() > 2 && text[0] == '0' && text[1] == 'x';
+    bool decimal = text[0] == '-' || text[0] != '0';
+    if (hex || decimal) {
+        LongInt value;
+        const char *first = text.data() + (hex ? 2 : 0);
+        auto parsed = from_chars(first, text.data() + text.size(), value, hex ? 16 : 10);
+        if (parsed.ec == errc() && parsed.ptr == text.data() + text.size() && text.size() <= 16) {
+            return value;
+        }
+    }
+    return parseValue(text);
+}
+
+bool parsePseudo(LineTokens &tokens, PseudoKind kind, PseudoInstruction &pseudo) {
+    pseudo.kind = kind;
+    Token token;
+    switch (kind) {
+    case PseudoKind::Nop:
+    case PseudoKind::Ret:
+        return true;
+    case PseudoKind::Mv:
+        return registerOperand(tokens, pseudo.rd) && registerOperand(tokens, pseudo.rs);
+    case PseudoKind::Li:
+        if (!registerOperand(tokens, pseudo.rd) || !tokens.operand(token)) {
+            return false;
+        }
+        // parseValue reads other words as the sum of their characters
+        if (!isdigit(static_cast<unsigned char>(token.text[0])) && token.text[0] != '-') {
+            return tokens.fail(token, "li takes a number, got '" + string(token.text) + "' (la loads an address)");
+        }
+        pseudo.value = constantValue(token.text);
+        if (pseudo.value < INT32_MIN || pseudo.value > UINT32_MAX) {
+            return tokens.fail(token, "immediate '" + string(token.text) + "' is not a 32-bit value");
+        }
+        return true;
+    case PseudoKind::La:
+        return registerOperand(tokens, pseudo.rd) && labelOperand(tokens, pseudo.label);
+    case PseudoKind::J:
+        if (!tokens.operand(token)) {
+            return false;
+        }
+        // Numeric offsets go to jal as they are
+        if (all_of(token.text.begin(), token.text.end(), ::isdigit)) {
+            pseudo.offset = token.text;
+            return true;
+        }
+        return labelName(tokens, token, pseudo.label);
+    case PseudoKind::Call:
+        return labelOperand(tokens, pseudo.label);
+    }
+    return false;
+}
+
+// Upper and lower immediates whose lui + addi make value
+static void splitValue(LongInt value, int32_t &upper, int32_t &lower) {
+    int32_t word = static_cast<int32_t>(static_cast<uint32_t>(value));
+    lower = static_cast<int32_t>(static_cast<uint32_t>(word) << 20) >> 20;
+    upper = static_cast<int32_t>(((static_cast<uint32_t>(word) - lower) >> 12) & 0xFFFFF);
+}
+
+int pseudoLength(const PseudoInstruction &pseudo, bool defined, LongInt target, LongInt address, bool fixedTarget) {
+    int32_t upper, lower;
+    switch (pseudo.kind) {
+    case PseudoKind::Li:
+        splitValue(pseudo.value, upper, lower);
+        return (upper == 0 || lower == 0) ? 1 : 2;
+    case PseudoKind::La:
+        return (defined && fixedTarget && (target & 0xFFF) == 0) ? 1 : 2;
+    case PseudoKind::J:
+    case PseudoKind::Call:
+        // A label defined nowhere in this source is left to the linker,
+        // which reports it if jal cannot reach it
+        return (!defined || (target - address >= JAL_MIN && target - address <= JAL_MAX)) ? 1 : 2;
+    default:
+        return 1;
+    }
+}
+
+static string reg(int number) {
+    return "x" + to_string(number);
+}
+
+void expandPseudo(const PseudoInstruction &pseudo, int length, string_view indent, vector<string> &lines) {
+    auto emit = [&](const string &text) {
+        lines.push_back(string(indent) + text);
+    };
+    string label(pseudo.label);
+    int32_t upper, lower;
+    char hex[16];
+    switch (pseudo.kind) {
+    case PseudoKind::Nop:
+        emit("addi x0, x0, 0");
+        break;
+    case PseudoKind::Mv:
+        emit("addi " + reg(pseudo.rd) + ", " + reg(pseudo.rs) + ", 0");
+        break;
+    case PseudoKind::Ret:
+        emit("jalr x0, x1, 0");
+        break;
+    case PseudoKind::Li:
+        splitValue(pseudo.value, upper, lower);
+        if (upper == 0) {
+            emit("addi " + reg(pseudo.rd) + ", x0, " + to_string(lower));
+            break;
+        }
+        snprintf(hex, sizeof(hex), "0x%x", upper);
+        emit("lui " + reg(pseudo.rd) + ", " + hex);
+        if (lower != 0) emit("addi " + reg(pseudo.rd) + ", " + reg(pseudo.rd) + ", " + to_string(lower));
+        break;
+    case PseudoKind::La:
+        emit("lui " + reg(pseudo.rd) + ", %hi(" + label + ")");
+        if (length > 1) emit("addi " + reg(pseudo.rd) + ", " + reg(pseudo.rd) + ", %lo(" + label + ")");
+        break;
+    case PseudoKind::J:
+    case PseudoKind::Call: {
+        // Far calls put the return address register to use; far jumps
+        // take t1 (x6), as the tail pseudo-instruction does elsewhere
+        string link = pseudo.kind == PseudoKind::Call ? "x1" : "x0";
+        if (length == 1) {
+            emit("jal " + link + ", " + (pseudo.label.empty() ? string(pseudo.offset) : label));
+            break;
+        }
+        string base = pseudo.kind == PseudoKind::Call ? "x1" : "x6";
+        emit("auipc " + base + ", %pcrel_hi(" + label + ")");
+        emit("jalr " + link + ", " + base + ", %pcrel_lo(" + label + ")");
+        break;
+    }
+    }
+}
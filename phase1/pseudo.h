@@ -0,0 +1,46 @@
+#include<string>
+#include<string_view>
+#include<vector>
+#include<lexer.h>
+#include<process.h>
+
+#ifndef PSEUDO_H
+#define PSEUDO_H
+using namespace std;
+
+enum class PseudoKind {
+    Nop,    // addi x0, x0, 0
+    Mv,     // addi rd, rs, 0
+    Ret,    // jalr x0, x1, 0
+    Li,     // addi, lui or lui + addi, by the value
+    La,     // lui %hi(label), plus addi %lo(label) unless the low bits are 0
+    J,      // jal x0, or auipc x6 + jalr x0 beyond the range of jal
+    Call,   // jal x1, or auipc x1 + jalr x1 beyond the range of jal
+};
+
+// Operands of a pseudo-instruction line
+struct PseudoInstruction {
+    PseudoKind kind;
+    int rd = 0;
+    int rs = 0;
+    LongInt value = 0;      // li: the constant
+    string_view label;      // la, call and j: the target; empty for j to a numeric offset
+    string_view offset;     // j: the numeric offset
+};
+
+// Kind of the pseudo-instruction named mnemonic; false for anything else
+bool findPseudo(string_view mnemonic, PseudoKind &kind);
+
+// Read the operands after the mnemonic of tokens; false with the error in tokens
+bool parsePseudo(LineTokens &tokens, PseudoKind kind, PseudoInstruction &pseudo);
+
+// Instructions in the shortest expansion of pseudo at address. For la,
+// call and j the label is at target if defined; fixedTarget says that
+// target is its final address, which la needs to drop the addi.
+int pseudoLength(const PseudoInstruction &pseudo, bool defined, LongInt target, LongInt address, bool fixedTarget);
+
+// Append the base instruction lines of pseudo in length instructions
+// (at least pseudoLength), each after the given indentation
+void expandPseudo(const PseudoInstruction &pseudo, int length, string_view indent, vector<string> &lines);
+
+#endif
@@ -0,0 +1,231 @@
+#include<scheduler.h>
+#include<algorithm>
+
+using namespace std;
+
+// Movable instructions scheduled together; bounds the quadratic search
+const size_t WINDOW = 64;
+
+// Registers and memory an instruction touches. Register x0 is never a
+// dependence, as in detectDataHazard().
+struct Node {
+    int reads[2];
+    int writes;         // -1 if none
+    bool load;
+    bool store;
+    bool fixed;         // Keeps its place: control, pc-relative or failed
+    bool control;       // Ends a basic block: a branch, jump, fence, ecall or ebreak
+};
+
+static Node describe(const AssembledInstruction &inst) {
+    Node node{{-1, -1}, -1, false, false, true, false};
+    if (inst.entry == nullptr) {
+        return node;
+    }
+    const IsaEntry &entry = *inst.entry;
+    if (layoutReadsRs1(entry.layout) && rs1Field(inst.word) != 0) node.reads[0] = rs1Field(inst.word);
+    if (layoutReadsRs2(entry.layout) && rs2Field(inst.word) != 0) node.reads[1] = rs2Field(inst.word);
+    if (layoutWritesRd(entry.layout) && rdField(inst.word) != 0) node.writes = rdField(inst.word);
+    node.load = entry.type == InstType::Load;
+    node.store = entry.type == InstType::S;
+    node.control = entry.type == InstType::SB || entry.type == InstType::JAL || entry.type == InstType::JALR ||
+                   entry.layout == OperandLayout::None;
+    bool pcRelative = inst.symbol >= 0 && (inst.relocation == RelocationType::PcrelHi || inst.relocation == RelocationType::PcrelLo);
+    node.fixed = node.control || pcRelative || entry.type == InstType::AUIPC;
+    return node;
+}
+
+// Issue timing within a block: each instruction enters ID a cycle after
+// the one before it unless an operand is not ready
+struct PipelineState {
+    LongInt cycle = -1;         // When the last instruction issued
+    LongInt ready[32] = {};     // First cycle a reader of each register may issue
+
+    void reset() { *this = PipelineState(); }
+
+    LongInt issueCycle(const Node &node) const {
+        LongInt issue = cycle + 1;
+        for (int reg : node.reads) {
+            if (reg > 0) issue = max(issue, ready[reg]);
+        }
+        return issue;
+    }
+
+    // Issue node and return its stall cycles
+    LongInt issue(const Node &node, bool forwarding) {
+        LongInt at = issueCycle(node);
+        LongInt stalls = at - (cycle + 1);
+        cycle = at;
+        if (node.writes > 0) {
+            // A load's result reaches EX from MEM/WB a cycle late; without
+            // forwarding a reader waits until the producer has left WB
+            ready[node.writes] = forwarding ? (node.load ? at + 2 : 0) : at + 4;
+        }
+        return stalls;
+    }
+};
+
+// Whether b, later in program order, must stay after a
+static bool dependsOn(const Node &b, const Node &a) {
+    for (int reg : b.reads) {
+        if (reg > 0 && reg == a.writes) return true;        // RAW
+    }
+    if (b.writes > 0) {
+        if (b.writes == a.writes) return true;                // WAW
+        if (b.writes == a.reads[0] || b.writes == a.reads[1]) return true;  // WAR
+    }
+    return (a.store && (b.load || b.store)) || (a.load && b.store);
+}
+
+// Addresses that may be jumped to: labels, and the targets of branches
+// and jumps given as numbers
+static vector<LongInt> blockStarts(const vector<AssembledInstruction> &text, const vector<LongInt> &labels) {
+    vector<LongInt> starts = labels;
+    for (const AssembledInstruction &inst : text) {
+        if (inst.entry == nullptr || inst.symbol >= 0) continue;
+        if (inst.entry->type == InstType::SB || inst.entry->type == InstType::JAL) {
+            starts.push_back(inst.address + isaImmediate(inst.entry->type, inst.word));
+        }
+    }
+    sort(starts.begin(), starts.end());
+    return starts;
+}
+
+// Calls visit(index, startsBlock) for each instruction in order, with
+// startsBlock set where a jump may land or after a branch or jump
+template <typename Visit>
+static void forEachInstruction(const vector<AssembledInstruction> &text, const vector<LongInt> &labels, Visit visit) {
+    vector<LongInt> starts = blockStarts(text, labels);
+    auto label = starts.begin();
+    bool afterControl = false;
+    for (size_t i = 0; i < text.size(); i++) {
+        bool startsBlock = afterControl;
+        while (label != starts.end() && *label <= text[i].address) {
+            startsBlock |= *label == text[i].address;
+            ++label;
+        }
+        afterControl = visit(i, startsBlock);
+    }
+}
+
+LongInt textStalls(const vector<AssembledInstruction> &text, const vector<LongInt> &labels, bool forwarding) {
+    PipelineState state;
+    LongInt stalls = 0;
+    forEachInstruction(text, labels, [&](size_t i, bool startsBlock) {
+        if (startsBlock) state.reset();
+        Node node = describe(text[i]);
+        stalls += state.issue(node, forwarding);
+        return node.control;
+    });
+    return stalls;
+}
+
+// Greedy list schedule of nodes from state: each step issues the ready
+// instruction that can go earliest, preferring the one with the longest
+// chain of dependents, then program order. Returns the order.
+static vector<size_t> listSchedule(const vector<Node> &nodes, PipelineState state, bool forwarding) {
+    size_t count = nodes.size();
+    vector<vector<size_t>> successors(count);
+    vector<int> waiting(count, 0);
+    for (size_t b = 0; b < count; b++) {
+        for (size_t a = 0; a < b; a++) {
+            if (dependsOn(nodes[b], nodes[a])) {
+                successors[a].push_back(b);
+                waiting[b]++;
+            }
+        }
+    }
+    // Latency-weighted height: a producer feeding a reader counts the
+    // cycles the reader would otherwise wait
+    vector<LongInt> height(count, 1);
+    for (size_t a = count; a-- > 0;) {
+        for (size_t b : successors[a]) {
+            bool raw = nodes[b].reads[0] == nodes[a].writes || nodes[b].reads[1] == nodes[a].writes;
+            LongInt latency = !raw ? 1 : forwarding ? (nodes[a].load ? 2 : 1) : 4;
+            height[a] = max(height[a], height[b] + latency);
+        }
+    }
+
+    vector<size_t> order;
+    vector<bool> done(count, false);
+    while (order.size() < count) {
+        size_t best = count;
+        LongInt bestCycle = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (done[i] || waiting[i] > 0) continue;
+            LongInt cycle = state.issueCycle(nodes[i]);
+            if (best == count || cycle < bestCycle || (cycle == bestCycle && height[i] > height[best])) {
+                best = i;
+                bestCycle = cycle;
+            }
+        }
+        state.issue(nodes[best], forwarding);
+        done[best] = true;
+        order.push_back(best);
+        for (size_t b : successors[best]) {
+            waiting[b]--;
+        }
+    }
+    return order;
+}
+
+ScheduleReport scheduleText(vector<AssembledInstruction> &text, const vector<LongInt> &labels, bool forwarding) {
+    ScheduleReport report;
+    report.stallsBefore = textStalls(text, labels, forwarding);
+
+    PipelineState state;
+    vector<size_t> window;      // Indexes of the movable run being collected
+    vector<Node> nodes;
+
+    // Schedule the collected run from state, keep the order with fewer
+    // stalls and advance state past it
+    auto flush = [&]() {
+        if (window.empty()) return;
+        vector<size_t> order = listSchedule(nodes, state, forwarding);
+        PipelineState original = state, scheduled = state;
+        LongInt originalStalls = 0, scheduledStalls = 0;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            originalStalls += original.issue(nodes[i], forwarding);
+            scheduledStalls += scheduled.issue(nodes[order[i]], forwarding);
+        }
+        if (scheduledStalls < originalStalls) {
+            vector<AssembledInstruction> moved;
+            for (size_t i : order) {
+                moved.push_back(move(text[window[i]]));
+            }
+            for (size_t i = 0; i < window.size(); i++) {
+                if (order[i] != i) report.moved++;
+                LongInt address = text[window[i]].address;
+                text[window[i]] = move(moved[i]);
+                text[window[i]].address = address;
+            }
+            state = scheduled;
+        }
+        else {
+            state = original;
+        }
+        window.clear();
+        nodes.clear();
+    };
+
+    forEachInstruction(text, labels, [&](size_t i, bool startsBlock) {
+        if (startsBlock) {
+            flush();
+            state.reset();
+        }
+        Node node = describe(text[i]);
+        if (node.fixed) {
+            flush();
+            state.issue(node, forwarding);
+            return node.control;
+        }
+        window.push_back(i);
+        nodes.push_back(node);
+        if (window.size() == WINDOW) flush();
+        return false;
+    });
+    flush();
+
+    report.stallsAfter = textStalls(text, labels, forwarding);
+    return report;
+}
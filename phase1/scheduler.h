@@ -0,0 +1,32 @@
+#include<vector>
+#include<process.h>
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+using namespace std;
+
+// Data-hazard stall cycles the pipelined simulator is expected to spend in
+// the text segment, before and after scheduling
+struct ScheduleReport {
+    LongInt stallsBefore = 0;
+    LongInt stallsAfter = 0;
+    size_t moved = 0;       // Instructions that ended up at another address
+};
+
+// Stall cycles of running the text straight through each basic block,
+// by the rules of detectAndHandleHazards() in phase3/hazards.cpp: with
+// forwarding only a load followed by a user of its result stalls, for
+// one cycle; without it an instruction waits in ID until every producer
+// of its operands has left WB. labels holds the sorted addresses of the
+// text labels, which start blocks.
+LongInt textStalls(const vector<AssembledInstruction> &text, const vector<LongInt> &labels, bool forwarding);
+
+// Reorder the instructions of each basic block to fill load-use and RAW
+// gaps, keeping register and memory dependences: loads stay on the same
+// side of every store, and stores keep their order. Branches, jumps,
+// pc-relative instructions (auipc, %pcrel_lo) and lines that failed to
+// encode keep their place, so labels keep their addresses and no word
+// needs re-encoding. A run is only reordered if that removes stalls.
+ScheduleReport scheduleText(vector<AssembledInstruction> &text, const vector<LongInt> &labels, bool forwarding);
+
+#endif
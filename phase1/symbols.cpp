@@ -0,0 +1,27 @@
+#include<symbols.h>
+
+using namespace std;
+
+// Id of a label name, adding it undefined the first time it is seen
+int SymbolTable::intern(string_view name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    int id = symbols.size();
+    ids.emplace(name, id);
+    symbols.push_back({name, 0, false});
+    return id;
+}
+
+// Id of a label name, or -1 if it has never been seen
+int SymbolTable::find(string_view name) const {
+    auto found = ids.find(name);
+    return found == ids.end() ? -1 : found->second;
+}
+
+// A later definition replaces an earlier one
+void SymbolTable::define(int id, LongInt value) {
+    symbols[id].value = value;
+    symbols[id].defined = true;
+}
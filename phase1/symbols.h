@@ -0,0 +1,31 @@
+#include<string_view>
+#include<vector>
+#include<unordered_map>
+
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+typedef long long LongInt;
+using namespace std;
+
+struct Symbol {
+    string_view name;   // Points into the source file
+    LongInt value;
+    bool defined;
+};
+
+// Label names interned to dense ids. References to a label that is not
+// defined yet hold its id and are patched once the whole file is read.
+class SymbolTable {
+public:
+    int intern(string_view name);
+    int find(string_view name) const;
+    void define(int id, LongInt value);
+    const Symbol &operator[](int id) const { return symbols[id]; }
+    int size() const { return symbols.size(); }
+
+private:
+    unordered_map<string_view, int> ids;
+    vector<Symbol> symbols;
+};
+
+#endif
@@ -0,0 +1,439 @@
+#include <bits/stdc++.h>
+#include "batch.h"
+#include "globals.h"
+#include "fastFunctional.h"
+#include "nonPipelined.h"
+#include "pipelined.h"
+#include "stack.h"
+#include "trace.h"
+#include "utils.h"
+
+using namespace std;
+
+const char *simulationModeName(SimulationMode mode)
+{
+    switch (mode)
+    {
+    case SimulationMode::Pipelined: return "pipelined";
+    case SimulationMode::Functional: return "functional";
+    case SimulationMode::Fast: return "fast";
+    }
+    return "pipelined";
+}
+
+bool parseSimulationMode(const string &name, SimulationMode &mode)
+{
+    if (name == "pipelined")
+        mode = SimulationMode::Pipelined;
+    else if (name == "functional")
+        mode = SimulationMode::Functional;
+    else if (name == "fast")
+        mode = SimulationMode::Fast;
+    else
+        return false;
+    return true;
+}
+
+static bool parseSwitch(const string &value, bool &flag)
+{
+    if (value == "on" || value == "1" || value == "true")
+        flag = true;
+    else if (value == "off" || value == "0" || value == "false")
+        flag = false;
+    else
+        return false;
+    return true;
+}
+
+bool parseJobFile(const string &filename, vector<BatchJob> &jobs)
+{
+    ifstream file(filename);
+    if (!file.is_open())
+    {
+        cerr << "Error opening job file: " << filename << endl;
+        return false;
+    }
+
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        istringstream tokens(line);
+        BatchJob job;
+        if (!(tokens >> job.file))
+        {
+            continue;
+        }
+
+        string setting;
+        while (tokens >> setting)
+        {
+            size_t equals = setting.find('=');
+            string key = setting.substr(0, equals);
+            string value = (equals != string::npos) ? setting.substr(equals + 1) : "";
+
+            bool ok = false;
+            if (key == "mode")
+                ok = parseSimulationMode(value, job.mode);
+            else if (key == "forwarding")
+                ok = parseSwitch(value, job.forwarding);
+            else if (key == "predictor")
+                ok = parsePredictorKind(value, job.predictor);
+            else if (key == "cache")
+                ok = parseSwitch(value, job.cache);
+            else if (key == "limit")
+            {
+                char *end = nullptr;
+                job.limit = strtoull(value.c_str(), &end, 10);
+                ok = !value.empty() && *end == '\0';
+            }
+
+            if (!ok)
+            {
+                cerr << "Error: " << filename << ":" << lineNumber << ": bad setting '" << setting << "'" << endl;
+                return false;
+            }
+        }
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// 32-bit FNV-1a over a byte range, continuing from hash
+static uint32_t fnv1a(const void *data, size_t size, uint32_t hash = 2166136261u)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+BatchResult runJob(const BatchJob &job)
+{
+    BatchResult result;
+    auto start = chrono::steady_clock::now();
+
+    knob_pipelining = (job.mode == SimulationMode::Pipelined);
+    knob_data_forwarding = job.forwarding;
+    knob_branch_predictor = job.predictor;
+    knob_cache = job.cache;
+
+    resetSimulatorState();
+    initializeStack();
+    if (!loadMC(job.file))
+    {
+        result.status = "error: cannot open " + job.file;
+        return result;
+    }
+    currentPC = entryPC;
+
+    bool finished = false;
+    switch (job.mode)
+    {
+    case SimulationMode::Pipelined:
+        result.cycles = runPipeline(job.limit);
+        result.instructions = total_instructions;
+        finished = exitSimulator;
+        break;
+    case SimulationMode::Functional:
+        result.instructions = runNonPipelined(job.limit);
+        result.cycles = result.instructions;
+        finished = exitSimulator || infLoop || !isValidPC(currentPC);
+        break;
+    case SimulationMode::Fast:
+        result.instructions = runFastFunctional(job.limit);
+        result.cycles = result.instructions;
+        finished = exitSimulator || infLoop || !isValidPC(currentPC);
+        break;
+    }
+
+    result.status = finished ? "done" : "limit";
+    result.stalls = pipeline_stalls;
+    result.dataHazards = data_hazards;
+    result.controlHazards = control_hazards;
+    result.mispredictions = branch_mispredictions;
+    result.l1iMisses = cacheHierarchy.l1i.getStats().misses;
+    result.l1dMisses = cacheHierarchy.l1d.getStats().misses;
+    result.l2Misses = cacheHierarchy.l2.getStats().misses;
+
+    result.registerHash = fnv1a(registerFile, sizeof(registerFile));
+    uint32_t memoryHash = 2166136261u;
+    dataMemory.forEachPage([&](uint32_t base, const uint8_t *page)
+                           {
+                               memoryHash = fnv1a(&base, sizeof(base), memoryHash);
+                               memoryHash = fnv1a(page, PagedMemory::PAGE_SIZE, memoryHash);
+                           });
+    result.memoryHash = memoryHash;
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// Fixed set of workers, each owning a deque of job indices. A worker takes
+// work from the back of its own deque and, once that is empty, steals from
+// the front of the others, so long jobs do not leave threads idle.
+class WorkStealingPool
+{
+public:
+    WorkStealingPool(size_t jobCount, unsigned workers) : queues(workers)
+    {
+        // Deal jobs round-robin so each worker starts with a similar mix
+        for (size_t job = 0; job < jobCount; job++)
+        {
+            queues[job % workers].jobs.push_back(job);
+        }
+    }
+
+    // Next job for worker, or false when every queue is empty. Jobs never
+    // create jobs, so an empty sweep means the batch is drained.
+    bool next(unsigned worker, size_t &job)
+    {
+        {
+            Queue &own = queues[worker];
+            lock_guard<mutex> lock(own.lock);
+            if (!own.jobs.empty())
+            {
+                job = own.jobs.back();
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < queues.size(); offset++)
+        {
+            Queue &victim = queues[(worker + offset) % queues.size()];
+            lock_guard<mutex> lock(victim.lock);
+            if (!victim.jobs.empty())
+            {
+                job = victim.jobs.front();
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue
+    {
+        mutex lock;
+        deque<size_t> jobs;
+    };
+
+    vector<Queue> queues;
+};
+
+vector<BatchResult> runBatch(const vector<BatchJob> &jobs, unsigned threads)
+{
+    vector<BatchResult> results(jobs.size());
+    if (jobs.empty())
+    {
+        return results;
+    }
+
+    if (threads == 0)
+    {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(min<size_t>(threads, jobs.size()));
+
+    // The trace ring takes one producer at a time
+    traceFlush();
+    uint8_t savedLevels[static_cast<size_t>(TraceCategory::Count)];
+    memcpy(savedLevels, traceLevels, sizeof(savedLevels));
+    traceSetAllLevels(TraceLevel::Off);
+
+    // Cache geometry is per thread; hand the caller's to every worker
+    const CacheConfig l1i = cacheHierarchy.l1i.getConfig();
+    const CacheConfig l1d = cacheHierarchy.l1d.getConfig();
+    const CacheConfig l2 = cacheHierarchy.l2.getConfig();
+    const uint32_t memoryLatency = cacheHierarchy.getMemoryLatency();
+
+    WorkStealingPool pool(jobs.size(), threads);
+    auto worker = [&](unsigned id)
+    {
+        cacheHierarchy.configure(l1i, l1d, l2, memoryLatency);
+
+        size_t job;
+        while (pool.next(id, job))
+        {
+            try
+            {
+                results[job] = runJob(jobs[job]);
+            }
+            catch (const exception &e)
+            {
+                results[job] = BatchResult();
+                results[job].status = string("error: ") + e.what();
+            }
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned id = 0; id < threads; id++)
+    {
+        workers.emplace_back(worker, id);
+    }
+
+    for (thread &t : workers)
+    {
+        t.join();
+    }
+
+    memcpy(traceLevels, savedLevels, sizeof(savedLevels));
+    return results;
+}
+
+// Quote a string for JSON output
+static string jsonString(const string &text)
+{
+    string out = "\"";
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            out += escape;
+        }
+        else
+        {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Quote a CSV field if it holds a separator, quote or newline
+static string csvField(const string &text)
+{
+    if (text.find_first_of(",\"\n") == string::npos)
+    {
+        return text;
+    }
+    string out = "\"";
+    for (char c : text)
+    {
+        if (c == '"')
+            out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+bool writeBatchResults(const string &filename, const vector<BatchJob> &jobs, const vector<BatchResult> &results)
+{
+    ofstream out(filename);
+    if (!out.is_open())
+    {
+        cerr << "Error opening result file: " << filename << endl;
+        return false;
+    }
+
+    bool json = filename.size() >= 5 && filename.compare(filename.size() - 5, 5, ".json") == 0;
+    out << fixed;
+
+    if (json)
+    {
+        out << "[\n";
+    }
+    else
+    {
+        out << "file,mode,forwarding,predictor,cache,limit,status,cycles,instructions,cpi,stalls,"
+               "data_hazards,control_hazards,mispredictions,l1i_misses,l1d_misses,l2_misses,"
+               "registers,memory,seconds\n";
+    }
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        const BatchJob &job = jobs[i];
+        const BatchResult &r = results[i];
+        double cpi = (r.instructions > 0) ? static_cast<double>(r.cycles) / r.instructions : 0;
+
+        char registers[16], memory[16];
+        snprintf(registers, sizeof(registers), "%08x", r.registerHash);
+        snprintf(memory, sizeof(memory), "%08x", r.memoryHash);
+
+        // An unlimited job reports a limit of 0
+        uint64_t limit = (job.limit == UINT64_MAX) ? 0 : job.limit;
+
+        if (json)
+        {
+            out << "  {\"file\": " << jsonString(job.file)
+                << ", \"mode\": \"" << simulationModeName(job.mode) << "\""
+                << ", \"forwarding\": " << (job.forwarding ? "true" : "false")
+                << ", \"predictor\": \"" << predictorName(job.predictor) << "\""
+                << ", \"cache\": " << (job.cache ? "true" : "false")
+                << ", \"limit\": " << limit
+                << ", \"status\": " << jsonString(r.status)
+                << ", \"cycles\": " << r.cycles
+                << ", \"instructions\": " << r.instructions
+                << ", \"cpi\": " << setprecision(4) << cpi
+                << ", \"stalls\": " << r.stalls
+                << ", \"data_hazards\": " << r.dataHazards
+                << ", \"control_hazards\": " << r.controlHazards
+                << ", \"mispredictions\": " << r.mispredictions
+                << ", \"l1i_misses\": " << r.l1iMisses
+                << ", \"l1d_misses\": " << r.l1dMisses
+                << ", \"l2_misses\": " << r.l2Misses
+                << ", \"registers\": \"" << registers << "\""
+                << ", \"memory\": \"" << memory << "\""
+                << ", \"seconds\": " << setprecision(6) << r.seconds
+                << "}" << (i + 1 < jobs.size() ? "," : "") << "\n";
+        }
+        else
+        {
+            out << csvField(job.file) << ',' << simulationModeName(job.mode) << ','
+                << (job.forwarding ? "on" : "off") << ',' << predictorName(job.predictor) << ','
+                << (job.cache ? "on" : "off") << ',' << limit << ',' << csvField(r.status) << ','
+                << r.cycles << ',' << r.instructions << ',' << setprecision(4) << cpi << ','
+                << r.stalls << ',' << r.dataHazards << ',' << r.controlHazards << ','
+                << r.mispredictions << ',' << r.l1iMisses << ',' << r.l1dMisses << ',' << r.l2Misses << ','
+                << registers << ',' << memory << ',' << setprecision(6) << r.seconds << "\n";
+        }
+    }
+
+    if (json)
+    {
+        out << "]\n";
+    }
+    return true;
+}
+
+int runBatchFile(const string &jobFile, const string &resultFile, unsigned threads)
+{
+    vector<BatchJob> jobs;
+    if (!parseJobFile(jobFile, jobs))
+    {
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<BatchResult> results = runBatch(jobs, threads);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!writeBatchResults(resultFile, jobs, results))
+    {
+        return 1;
+    }
+
+    size_t failed = count_if(results.begin(), results.end(), [](const BatchResult &r)
+                             { return r.status.compare(0, 5, "error") == 0; });
+    cout << "Ran " << jobs.size() << " jobs in " << fixed << setprecision(3) << seconds << " s";
+    if (failed > 0)
+    {
+        cout << " (" << failed << " failed)";
+    }
+    cout << ", results written to " << resultFile << endl;
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+// batch.h
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "structs.h"
+
+// Execution model a simulation runs under
+enum class SimulationMode
+{
+    Pipelined,  // Five-stage pipeline with hazards, prediction and caches
+    Functional, // One instruction per cycle, non-pipelined model
+    Fast        // Predecoded threaded interpreter
+};
+
+const char *simulationModeName(SimulationMode mode);
+bool parseSimulationMode(const std::string &name, SimulationMode &mode);
+
+// One simulation of a batch
+struct BatchJob
+{
+    std::string file;                                // .mc program to load
+    SimulationMode mode = SimulationMode::Pipelined;
+    bool forwarding = true;                          // knob_data_forwarding
+    PredictorKind predictor = PredictorKind::OneBit; // knob_branch_predictor
+    bool cache = false;                              // knob_cache
+    uint64_t limit = UINT64_MAX;                     // Cycle budget (pipelined) or instruction budget
+};
+
+// Outcome of one job
+struct BatchResult
+{
+    std::string status;        // "done", "limit" (budget ran out) or "error: ..."
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    int stalls = 0;
+    int dataHazards = 0;
+    int controlHazards = 0;
+    int mispredictions = 0;
+    uint64_t l1iMisses = 0;
+    uint64_t l1dMisses = 0;
+    uint64_t l2Misses = 0;
+    uint32_t registerHash = 0; // FNV-1a of the final register file
+    uint32_t memoryHash = 0;   // FNV-1a of every allocated data page
+    double seconds = 0;        // Wall time of the run, loading included
+};
+
+// Read a job list. Each non-empty line names a .mc file followed by
+// optional key=value settings:
+//     mode=pipelined|functional|fast  forwarding=on|off
+//     predictor=not-taken|1bit|2bit   cache=on|off   limit=<count>
+// '#' starts a comment. Prints an error and returns false on a bad line.
+bool parseJobFile(const std::string &filename, std::vector<BatchJob> &jobs);
+
+// Run one job on the calling thread, replacing its simulator state
+BatchResult runJob(const BatchJob &job);
+
+// Run jobs on a work-stealing pool of threads (hardware concurrency when
+// threads is 0). Results come back in job order and the calling thread's
+// state is untouched. Tracing is switched off for the duration; workers
+// use the calling thread's cache geometry.
+std::vector<BatchResult> runBatch(const std::vector<BatchJob> &jobs, unsigned threads = 0);
+
+// Write one row per job as CSV, or as JSON if filename ends in ".json"
+bool writeBatchResults(const std::string &filename, const std::vector<BatchJob> &jobs,
+                       const std::vector<BatchResult> &results);
+
+// Parse jobFile, run it and write resultFile. Returns a process exit code.
+int runBatchFile(const std::string &jobFile, const std::string &resultFile, unsigned threads = 0);
+
+#endif // BATCH_H
@@ -0,0 +1,291 @@
+#include <bits/stdc++.h>
+#include "cache.h"
+
+using namespace std;
+
+// Fixed seed so random replacement is reproducible from run to run
+static constexpr uint64_t RANDOM_SEED = 0x9E3779B97F4A7C15ULL;
+
+static bool isPowerOfTwo(uint32_t value)
+{
+    return value != 0 && (value & (value - 1)) == 0;
+}
+
+static uint32_t log2Of(uint32_t value)
+{
+    uint32_t bits = 0;
+    while ((1u << bits) < value)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+Cache::Cache(const string &name) : name(name)
+{
+    configure(CacheConfig());
+}
+
+bool Cache::configure(const CacheConfig &newConfig)
+{
+    const CacheConfig &c = newConfig;
+
+    // Validate geometry before touching any state
+    if (!isPowerOfTwo(c.sizeBytes) || !isPowerOfTwo(c.associativity) || !isPowerOfTwo(c.lineSize))
+    {
+        cerr << "Error: " << name << " size, associativity and line size must be powers of two" << endl;
+        return false;
+    }
+    if (c.lineSize < 4 || static_cast<uint64_t>(c.associativity) * c.lineSize > c.sizeBytes)
+    {
+        cerr << "Error: " << name << " needs lines of at least 4 bytes and room for one full set" << endl;
+        return false;
+    }
+    if (c.replacement == ReplacementPolicy::PLRU && c.associativity > 64)
+    {
+        cerr << "Error: " << name << " tree PLRU supports at most 64 ways" << endl;
+        return false;
+    }
+    if (c.latency == 0)
+    {
+        cerr << "Error: " << name << " latency must be at least one cycle" << endl;
+        return false;
+    }
+
+    config = c;
+    numSets = c.sizeBytes / (c.associativity * c.lineSize);
+    offsetBits = log2Of(c.lineSize);
+    indexBits = log2Of(numSets);
+    reset();
+    return true;
+}
+
+void Cache::setNextLevel(Cache *next, uint32_t latency)
+{
+    nextLevel = next;
+    memoryLatency = latency;
+}
+
+void Cache::reset()
+{
+    lines.assign(static_cast<size_t>(numSets) * config.associativity, Line());
+    plruBits.assign(numSets, 0);
+    stats = CacheStats();
+    useCounter = 0;
+    randomState = RANDOM_SEED;
+}
+
+uint32_t Cache::access(uint32_t address, bool isWrite)
+{
+    if (isWrite)
+        stats.writes++;
+    else
+        stats.reads++;
+
+    uint32_t set = (address >> offsetBits) & (numSets - 1);
+    uint32_t tag = static_cast<uint32_t>(static_cast<uint64_t>(address) >> (offsetBits + indexBits));
+    Line *ways = &lines[static_cast<size_t>(set) * config.associativity];
+
+    // Hit: update recency and apply the write policy
+    for (uint32_t way = 0; way < config.associativity; way++)
+    {
+        if (ways[way].valid && ways[way].tag == tag)
+        {
+            stats.hits++;
+            touch(set, way);
+            if (isWrite)
+            {
+                if (config.writeBack)
+                    ways[way].dirty = true;
+                else
+                    writeDown(address);
+            }
+            return config.latency;
+        }
+    }
+
+    stats.misses++;
+
+    // Write miss without allocation goes straight to the next level
+    if (isWrite && !config.writeAllocate)
+    {
+        writeDown(address);
+        return config.latency;
+    }
+
+    // Fetch the line from below, then make room for it
+    uint32_t cycles = config.latency + missCost(address);
+
+    uint32_t way = chooseVictim(set);
+    Line &victim = ways[way];
+    if (victim.valid)
+    {
+        stats.evictions++;
+        if (victim.dirty)
+        {
+            stats.writebacks++;
+            uint64_t victimAddress = (static_cast<uint64_t>(victim.tag) << (offsetBits + indexBits)) |
+                                     (static_cast<uint64_t>(set) << offsetBits);
+            writeDown(static_cast<uint32_t>(victimAddress));
+        }
+    }
+
+    victim.valid = true;
+    victim.tag = tag;
+    victim.dirty = isWrite && config.writeBack;
+    touch(set, way);
+
+    if (isWrite && !config.writeBack)
+    {
+        writeDown(address);
+    }
+    return cycles;
+}
+
+// Cycles to bring a line in from the level below
+uint32_t Cache::missCost(uint32_t address)
+{
+    if (nextLevel != nullptr)
+    {
+        return nextLevel->access(address, false);
+    }
+    return memoryLatency;
+}
+
+// Send a write to the level below; main memory absorbs it silently
+void Cache::writeDown(uint32_t address)
+{
+    if (nextLevel != nullptr)
+    {
+        nextLevel->access(address, true);
+    }
+}
+
+uint32_t Cache::chooseVictim(uint32_t set)
+{
+    Line *ways = &lines[static_cast<size_t>(set) * config.associativity];
+
+    // Empty ways are always filled first
+    for (uint32_t way = 0; way < config.associativity; way++)
+    {
+        if (!ways[way].valid)
+        {
+            return way;
+        }
+    }
+
+    switch (config.replacement)
+    {
+    case ReplacementPolicy::LRU:
+    {
+        uint32_t victim = 0;
+        for (uint32_t way = 1; way < config.associativity; way++)
+        {
+            if (ways[way].lastUse < ways[victim].lastUse)
+            {
+                victim = way;
+            }
+        }
+        return victim;
+    }
+    case ReplacementPolicy::PLRU:
+    {
+        // Follow the tree bits towards the pseudo least recently used way
+        uint64_t bits = plruBits[set];
+        uint32_t node = 0, low = 0, span = config.associativity;
+        while (span > 1)
+        {
+            span /= 2;
+            bool right = (bits >> node) & 1;
+            node = 2 * node + 1 + (right ? 1 : 0);
+            if (right)
+                low += span;
+        }
+        return low;
+    }
+    case ReplacementPolicy::Random:
+    default:
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        return static_cast<uint32_t>(randomState % config.associativity);
+    }
+}
+
+void Cache::touch(uint32_t set, uint32_t way)
+{
+    lines[static_cast<size_t>(set) * config.associativity + way].lastUse = ++useCounter;
+
+    if (config.replacement == ReplacementPolicy::PLRU)
+    {
+        // Point every node on the path away from the way just used
+        uint64_t &bits = plruBits[set];
+        uint32_t node = 0, low = 0, span = config.associativity;
+        while (span > 1)
+        {
+            span /= 2;
+            bool right = way >= low + span;
+            if (right)
+                bits &= ~(1ULL << node);
+            else
+                bits |= (1ULL << node);
+            node = 2 * node + 1 + (right ? 1 : 0);
+            if (right)
+                low += span;
+        }
+    }
+}
+
+CacheHierarchy::CacheHierarchy()
+{
+    CacheConfig l1iConfig;
+    l1iConfig.associativity = 2;
+
+    CacheConfig l1dConfig;
+
+    CacheConfig l2Config;
+    l2Config.sizeBytes = 64 * 1024;
+    l2Config.associativity = 8;
+    l2Config.lineSize = 64;
+    l2Config.latency = 10;
+
+    configure(l1iConfig, l1dConfig, l2Config, 100);
+}
+
+bool CacheHierarchy::configure(const CacheConfig &l1iConfig, const CacheConfig &l1dConfig,
+                               const CacheConfig &l2Config, uint32_t latency)
+{
+    bool ok = l1i.configure(l1iConfig) && l1d.configure(l1dConfig) && l2.configure(l2Config);
+
+    memoryLatency = latency;
+    l1i.setNextLevel(&l2, memoryLatency);
+    l1d.setNextLevel(&l2, memoryLatency);
+    l2.setNextLevel(nullptr, memoryLatency);
+    return ok;
+}
+
+void CacheHierarchy::reset()
+{
+    l1i.reset();
+    l1d.reset();
+    l2.reset();
+}
+
+uint32_t CacheHierarchy::fetchStall(uint32_t pc)
+{
+    return l1i.access(pc, false) - 1;
+}
+
+uint32_t CacheHierarchy::dataStall(uint32_t address, uint32_t bytes, bool isWrite)
+{
+    uint32_t cycles = l1d.access(address, isWrite);
+
+    // An access that straddles two lines touches both of them
+    uint32_t last = address + bytes - 1;
+    uint32_t lineMask = ~(l1d.getConfig().lineSize - 1);
+    if ((last & lineMask) != (address & lineMask))
+    {
+        cycles += l1d.access(last, isWrite);
+    }
+    return cycles - 1;
+}
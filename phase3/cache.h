@@ -0,0 +1,126 @@
+// cache.h
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Victim selection within a set
+enum class ReplacementPolicy
+{
+    LRU,    // True least recently used (per-line timestamps)
+    PLRU,   // Tree pseudo-LRU, needs a power-of-two associativity
+    Random  // Deterministic xorshift generator
+};
+
+// Geometry, timing and policies of one cache level
+struct CacheConfig
+{
+    uint32_t sizeBytes = 4096;   // Total capacity
+    uint32_t associativity = 4;  // Ways per set
+    uint32_t lineSize = 32;      // Bytes per line
+    uint32_t latency = 1;        // Cycles to return a hit from this level
+    ReplacementPolicy replacement = ReplacementPolicy::LRU;
+    bool writeBack = true;       // Write-back if true, write-through otherwise
+    bool writeAllocate = true;   // Allocate a line on a write miss
+};
+
+// Per-level event counters
+struct CacheStats
+{
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;  // Valid lines replaced
+    uint64_t writebacks = 0; // Dirty lines written to the next level
+};
+
+// Tag-only timing model of one set-associative cache. Data always lives
+// in dataMemory; the cache only decides how long an access takes.
+class Cache
+{
+public:
+    explicit Cache(const std::string &name);
+
+    // Apply a configuration and invalidate every line. Prints an error and
+    // returns false if the geometry is not a power of two or does not fit.
+    bool configure(const CacheConfig &config);
+
+    // Lower level that serves misses, or nullptr for main memory
+    void setNextLevel(Cache *next, uint32_t memoryLatency);
+
+    // Access the line holding address and return the cycles it takes,
+    // including the time spent below this level on a miss. Writes sent
+    // downwards (write-through, no-allocate misses and dirty evictions)
+    // drain through a write buffer: they update the lower level's state
+    // and counters but add no cycles.
+    uint32_t access(uint32_t address, bool isWrite);
+
+    // Invalidate all lines and zero the counters
+    void reset();
+
+    const std::string &getName() const { return name; }
+    const CacheConfig &getConfig() const { return config; }
+    const CacheStats &getStats() const { return stats; }
+
+private:
+    struct Line
+    {
+        uint32_t tag = 0;
+        uint64_t lastUse = 0;
+        bool valid = false;
+        bool dirty = false;
+    };
+
+    std::string name;
+    CacheConfig config;
+    CacheStats stats;
+
+    uint32_t numSets = 0;
+    uint32_t offsetBits = 0;
+    uint32_t indexBits = 0;
+    std::vector<Line> lines;        // numSets * associativity, set-major
+    std::vector<uint64_t> plruBits; // One tree per set, bit i is node i
+
+    Cache *nextLevel = nullptr;
+    uint32_t memoryLatency = 0;
+    uint64_t useCounter = 0;
+    uint64_t randomState = 0;
+
+    uint32_t missCost(uint32_t address);
+    void writeDown(uint32_t address);
+    uint32_t chooseVictim(uint32_t set);
+    void touch(uint32_t set, uint32_t way);
+};
+
+// Split L1 instruction and data caches over a unified L2
+class CacheHierarchy
+{
+public:
+    Cache l1i{"L1I"};
+    Cache l1d{"L1D"};
+    Cache l2{"L2"};
+
+    CacheHierarchy();
+
+    // Configure all three levels. Returns false if any level is invalid.
+    bool configure(const CacheConfig &l1iConfig, const CacheConfig &l1dConfig,
+                   const CacheConfig &l2Config, uint32_t memoryLatency);
+
+    // Invalidate all levels and zero their counters
+    void reset();
+
+    // Cycles an access takes beyond the single cycle the pipeline stage
+    // already accounts for. Zero on an L1 hit with latency 1.
+    uint32_t fetchStall(uint32_t pc);
+    uint32_t dataStall(uint32_t address, uint32_t bytes, bool isWrite);
+
+    uint32_t getMemoryLatency() const { return memoryLatency; }
+
+private:
+    uint32_t memoryLatency = 100;
+};
+
+#endif // CACHE_H
@@ -0,0 +1,197 @@
+#include <bits/stdc++.h>
+#include <elf.h>
+#include "elfLoader.h"
+#include "globals.h"
+#include "utils.h"
+#include "trace.h"
+using namespace std;
+
+thread_local vector<ProgramSymbol> programSymbols;
+
+// Largest text segment accepted, in bytes
+static constexpr uint32_t MAX_TEXT_BYTES = 256 << 20;
+
+const ProgramSymbol *symbolAt(uint32_t address)
+{
+    auto after = upper_bound(programSymbols.begin(), programSymbols.end(), address,
+                             [](uint32_t value, const ProgramSymbol &symbol)
+                             { return value < symbol.address; });
+    if (after == programSymbols.begin())
+    {
+        return nullptr;
+    }
+    const ProgramSymbol &symbol = *prev(after);
+    if (symbol.size != 0 && address - symbol.address >= symbol.size)
+    {
+        return nullptr;
+    }
+    return &symbol;
+}
+
+string describeAddress(uint32_t address)
+{
+    char text[32];
+    const ProgramSymbol *symbol = symbolAt(address);
+    if (symbol == nullptr)
+    {
+        snprintf(text, sizeof(text), "0x%x", address);
+        return text;
+    }
+    if (address == symbol->address)
+    {
+        return symbol->name;
+    }
+    snprintf(text, sizeof(text), "+0x%x", address - symbol->address);
+    return symbol->name + text;
+}
+
+// True if [offset, offset + length) lies inside a file of size bytes
+static bool inFile(uint64_t offset, uint64_t length, size_t size)
+{
+    return offset <= size && length <= size - offset;
+}
+
+// Named functions and objects from the first SHT_SYMTAB section
+static void readSymbols(const char *contents, size_t size, const Elf32_Ehdr &header)
+{
+    if (header.e_shoff == 0 || header.e_shentsize != sizeof(Elf32_Shdr) ||
+        !inFile(header.e_shoff, uint64_t(header.e_shnum) * sizeof(Elf32_Shdr), size))
+    {
+        return;
+    }
+    const char *sections = contents + header.e_shoff;
+    auto section = [&](uint32_t index)
+    {
+        Elf32_Shdr entry;
+        memcpy(&entry, sections + index * sizeof(Elf32_Shdr), sizeof(entry));
+        return entry;
+    };
+
+    for (uint32_t i = 0; i < header.e_shnum; i++)
+    {
+        Elf32_Shdr symtab = section(i);
+        if (symtab.sh_type != SHT_SYMTAB || symtab.sh_link >= header.e_shnum)
+        {
+            continue;
+        }
+        Elf32_Shdr strtab = section(symtab.sh_link);
+        if (!inFile(symtab.sh_offset, symtab.sh_size, size) || !inFile(strtab.sh_offset, strtab.sh_size, size))
+        {
+            return;
+        }
+        const char *names = contents + strtab.sh_offset;
+        for (uint32_t offset = 0; offset + sizeof(Elf32_Sym) <= symtab.sh_size; offset += sizeof(Elf32_Sym))
+        {
+            Elf32_Sym symbol;
+            memcpy(&symbol, contents + symtab.sh_offset + offset, sizeof(symbol));
+            int type = ELF32_ST_TYPE(symbol.st_info);
+            if (symbol.st_shndx == SHN_UNDEF || symbol.st_shndx == SHN_ABS || symbol.st_name >= strtab.sh_size ||
+                (type != STT_NOTYPE && type != STT_FUNC && type != STT_OBJECT))
+            {
+                continue;
+            }
+            const char *name = names + symbol.st_name;
+            size_t length = strnlen(name, strtab.sh_size - symbol.st_name);
+            // Skip unnamed entries and local labels such as .L12 or $x
+            if (length == 0 || name[0] == '.' || name[0] == '$')
+            {
+                continue;
+            }
+            programSymbols.push_back({symbol.st_value, symbol.st_size, string(name, length)});
+        }
+        break;
+    }
+    sort(programSymbols.begin(), programSymbols.end(),
+         [](const ProgramSymbol &a, const ProgramSymbol &b)
+         { return a.address < b.address; });
+}
+
+bool loadELF(const char *contents, size_t size, const string &filename)
+{
+    auto fail = [&](const char *problem)
+    {
+        cerr << "Error loading " << filename << ": " << problem << endl;
+        return false;
+    };
+
+    Elf32_Ehdr header;
+    if (size < sizeof(header))
+    {
+        return fail("truncated ELF header");
+    }
+    memcpy(&header, contents, sizeof(header));
+    if (header.e_ident[EI_CLASS] != ELFCLASS32 || header.e_ident[EI_DATA] != ELFDATA2LSB)
+    {
+        return fail("not a little-endian ELF32 file");
+    }
+    if (header.e_machine != EM_RISCV || header.e_type != ET_EXEC)
+    {
+        return fail("not a RISC-V executable");
+    }
+    if (header.e_phentsize != sizeof(Elf32_Phdr) ||
+        !inFile(header.e_phoff, uint64_t(header.e_phnum) * sizeof(Elf32_Phdr), size))
+    {
+        return fail("bad program header table");
+    }
+
+    vector<Elf32_Phdr> segments;
+    uint64_t textLow = UINT64_MAX, textHigh = 0;
+    for (uint32_t i = 0; i < header.e_phnum; i++)
+    {
+        Elf32_Phdr segment;
+        memcpy(&segment, contents + header.e_phoff + i * sizeof(Elf32_Phdr), sizeof(segment));
+        if (segment.p_type != PT_LOAD)
+        {
+            continue;
+        }
+        if (!inFile(segment.p_offset, segment.p_filesz, size) || segment.p_filesz > segment.p_memsz ||
+            uint64_t(segment.p_vaddr) + segment.p_memsz > (1ull << 32))
+        {
+            return fail("PT_LOAD segment outside the file or address space");
+        }
+        if ((segment.p_flags & PF_X) && segment.p_memsz > 0)
+        {
+            textLow = min<uint64_t>(textLow, segment.p_vaddr);
+            textHigh = max<uint64_t>(textHigh, uint64_t(segment.p_vaddr) + segment.p_memsz);
+        }
+        segments.push_back(segment);
+    }
+    if (textLow != UINT64_MAX && textHigh - textLow > MAX_TEXT_BYTES)
+    {
+        return fail("executable segments span too much memory");
+    }
+
+    // Executable segments become the text image as well, so instructions
+    // can also be read as data (literal pools, jump tables)
+    textSegment.clear();
+    textBase = 0;
+    if (textLow != UINT64_MAX)
+    {
+        textBase = static_cast<uint32_t>(textLow) & ~3u;
+        textSegment.assign((textHigh - textBase + 3) / 4, 0);
+    }
+    uint64_t dataBytes = 0;
+    for (const Elf32_Phdr &segment : segments)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(contents + segment.p_offset);
+        dataMemory.writeBytes(segment.p_vaddr, bytes, segment.p_filesz);
+        dataMemory.fill(segment.p_vaddr + segment.p_filesz, 0, segment.p_memsz - segment.p_filesz);
+        dataBytes += segment.p_memsz;
+        if ((segment.p_flags & PF_X) && segment.p_filesz > 0)
+        {
+            memcpy(reinterpret_cast<uint8_t *>(textSegment.data()) + (segment.p_vaddr - textBase), bytes, segment.p_filesz);
+        }
+    }
+    textData = textSegment.data();
+    textWordCount = textSegment.size();
+    entryPC = header.e_entry;
+
+    programSymbols.clear();
+    readSymbols(contents, size, header);
+
+    lastLoad.instructions = textWordCount;
+    lastLoad.dataBytes = dataBytes;
+    TRACE(Cycle, Info, "Loaded %u text words and %llu bytes of memory; entry 0x%x.\n",
+          textWordCount, dataBytes, entryPC);
+    return true;
+}
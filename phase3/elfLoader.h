@@ -0,0 +1,34 @@
+// elfLoader.h
+#ifndef ELFLOADER_H
+#define ELFLOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Named address from the symbol table of a loaded ELF file
+struct ProgramSymbol
+{
+    uint32_t address;
+    uint32_t size; // 0 when the symbol table gives none
+    std::string name;
+};
+
+// Symbols of the loaded program by address; empty for .mc files
+extern thread_local std::vector<ProgramSymbol> programSymbols;
+
+// Symbol at or below address, or nullptr if there is none
+const ProgramSymbol *symbolAt(uint32_t address);
+
+// "name+0x10" for address, or its hex value if no symbol covers it
+std::string describeAddress(uint32_t address);
+
+// Load a little-endian ELF32 RISC-V executable from an image of the file.
+// Every PT_LOAD segment is copied into data memory, with p_memsz beyond
+// p_filesz reading as zero; executable segments also form the text
+// segment. Sets entryPC from e_entry and fills programSymbols. Prints the
+// problem and returns false if the file is not a usable executable.
+bool loadELF(const char *contents, size_t size, const std::string &filename);
+
+#endif // ELFLOADER_H
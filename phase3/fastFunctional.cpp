@@ -0,0 +1,411 @@
+#include <bits/stdc++.h>
+#include "globals.h"
+#include "structs.h"
+#include "fastFunctional.h"
+#include "nonPipelined.h"
+#include "stack.h"
+#include "utils.h"
+#include "trace.h"
+
+using namespace std;
+
+// Handler index of a micro-op: the mnemonic ID, plus EXIT for addi x0 x0 1,
+// ecall and ebreak.
+// Mnemonic::NOP and Mnemonic::UNKNOWN mark holes and stop execution.
+constexpr uint8_t OP_EXIT = static_cast<uint8_t>(Mnemonic::UNKNOWN) + 1;
+constexpr uint8_t OP_COUNT = OP_EXIT + 1;
+
+// Discard register for instructions with rd = x0
+constexpr uint8_t REG_SINK = 32;
+
+// Target slot of a branch or JAL that leaves the text segment
+constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+// Predecoded instruction
+struct MicroOp
+{
+    const void *handler; // Label address, filled in by runFastFunctional()
+    uint8_t op;          // Handler index
+    uint8_t rd;          // Destination register (REG_SINK when discarded)
+    uint8_t rs1;         // First source register
+    uint8_t rs2;         // Second source register
+    int32_t imm;         // Sign-extended immediate
+    uint32_t target;     // Slot of a branch or JAL target
+};
+
+// Decode the whole text segment once. One slot per word plus a trailing
+// stop slot, so falling off the end needs no bounds check.
+static vector<MicroOp> predecode()
+{
+    uint32_t count = textSegment.size();
+    vector<MicroOp> ops(count + 1);
+
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        MicroOp &op = ops[slot];
+        uint32_t word = textSegment[slot];
+        if (word == 0)
+        {
+            op.op = static_cast<uint8_t>(Mnemonic::NOP);
+            continue;
+        }
+
+        Instruction inst = decodeWord(word);
+        op.op = static_cast<uint8_t>(inst.name);
+        op.rd = (inst.rd == 0) ? REG_SINK : inst.rd;
+        op.rs1 = inst.rs1;
+        op.rs2 = inst.rs2;
+        op.imm = static_cast<int32_t>(inst.imm);
+        op.target = NO_SLOT;
+
+        if (isExitInstruction(inst))
+        {
+            op.op = OP_EXIT;
+        }
+
+        // PC-relative targets are resolved to slots here
+        if (inst.type == InstType::SB || inst.type == InstType::JAL)
+        {
+            uint32_t targetPC = textBase + 4 * slot + op.imm;
+            uint32_t index = (targetPC - textBase) >> 2;
+            if (targetPC >= textBase && (targetPC & 3) == 0 && index < count)
+            {
+                op.target = index;
+            }
+        }
+    }
+    ops[count].op = static_cast<uint8_t>(Mnemonic::NOP);
+    return ops;
+}
+
+uint64_t runFastFunctional(uint64_t maxInstructions)
+{
+    vector<MicroOp> ops = predecode();
+    const uint32_t count = textSegment.size();
+
+    // Handler table indexed by MicroOp::op, in Mnemonic order
+    static const void *const handlers[] = {
+        &&do_stop,
+        &&do_add, &&do_sub, &&do_mul, &&do_div, &&do_rem, &&do_and, &&do_or, &&do_xor,
+        &&do_sll, &&do_srl, &&do_sra, &&do_slt,
+        &&do_sltu, &&do_mulh, &&do_mulhsu, &&do_mulhu, &&do_divu, &&do_remu,
+        &&do_addi, &&do_andi, &&do_ori, &&do_xori, &&do_slti, &&do_sltiu, &&do_slli, &&do_srli, &&do_srai,
+        &&do_lb, &&do_lh, &&do_lw, &&do_ld, &&do_lbu, &&do_lhu,
+        &&do_sb, &&do_sh, &&do_sw, &&do_sd,
+        &&do_beq, &&do_bne, &&do_blt, &&do_bge, &&do_bltu, &&do_bgeu,
+        &&do_lui, &&do_auipc, &&do_jal, &&do_jalr,
+        &&do_fence, &&do_exit, &&do_exit,
+        &&do_stop,
+        &&do_exit};
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == OP_COUNT, "handler table out of sync with Mnemonic");
+
+    for (MicroOp &op : ops)
+    {
+        op.handler = handlers[op.op];
+    }
+
+    // Work on a local copy of the register file; slot 32 absorbs x0 writes
+    int32_t regs[33];
+    for (int i = 0; i < 32; i++)
+    {
+        regs[i] = registerFile[i];
+    }
+    regs[0] = 0;
+
+    uint64_t executed = 0;
+    uint32_t pc = currentPC;
+    const MicroOp *op = nullptr;
+
+    {
+        uint32_t index = (pc - textBase) >> 2;
+        if (pc < textBase || (pc & 3) != 0 || index >= count)
+        {
+            goto leave;
+        }
+        op = ops.data() + index;
+    }
+
+// Slot address of the current micro-op
+#define PC_OF(p) (textBase + 4 * static_cast<uint32_t>((p) - ops.data()))
+
+// Enter the handler of op, stopping when the instruction budget is spent
+#define DISPATCH()                            \
+    do                                        \
+    {                                         \
+        if (executed == maxInstructions)      \
+        {                                     \
+            pc = PC_OF(op);                   \
+            goto leave;                       \
+        }                                     \
+        executed++;                           \
+        goto *op->handler;                    \
+    } while (0)
+
+// rs1 + imm with 32-bit wrap-around
+#define EFFECTIVE_ADDRESS() (static_cast<uint32_t>(regs[op->rs1]) + op->imm)
+
+#define NEXT()      \
+    do              \
+    {               \
+        op++;       \
+        DISPATCH(); \
+    } while (0)
+
+// Continue at a predecoded branch or JAL target
+#define JUMP_TO_TARGET()                              \
+    do                                                \
+    {                                                 \
+        if (op->target == NO_SLOT)                    \
+        {                                             \
+            pc = PC_OF(op) + op->imm;                 \
+            goto leave;                               \
+        }                                             \
+        if (ops.data() + op->target == op)            \
+        {                                             \
+            infLoop = true;                           \
+            pc = PC_OF(op);                           \
+            goto leave;                               \
+        }                                             \
+        op = ops.data() + op->target;                 \
+        DISPATCH();                                   \
+    } while (0)
+
+    DISPATCH();
+
+do_add:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) + static_cast<uint32_t>(regs[op->rs2]));
+    NEXT();
+do_sub:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) - static_cast<uint32_t>(regs[op->rs2]));
+    NEXT();
+do_mul:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) * static_cast<uint32_t>(regs[op->rs2]));
+    NEXT();
+do_div:
+    regs[op->rd] = (regs[op->rs2] == 0) ? -1 : static_cast<int32_t>(static_cast<int64_t>(regs[op->rs1]) / regs[op->rs2]);
+    NEXT();
+do_rem:
+    regs[op->rd] = (regs[op->rs2] == 0) ? regs[op->rs1] : static_cast<int32_t>(static_cast<int64_t>(regs[op->rs1]) % regs[op->rs2]);
+    NEXT();
+do_and:
+    regs[op->rd] = regs[op->rs1] & regs[op->rs2];
+    NEXT();
+do_or:
+    regs[op->rd] = regs[op->rs1] | regs[op->rs2];
+    NEXT();
+do_xor:
+    regs[op->rd] = regs[op->rs1] ^ regs[op->rs2];
+    NEXT();
+do_sll:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) << (regs[op->rs2] & 0x1F));
+    NEXT();
+do_srl:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) >> (regs[op->rs2] & 0x1F));
+    NEXT();
+do_sra:
+    regs[op->rd] = regs[op->rs1] >> (regs[op->rs2] & 0x1F);
+    NEXT();
+do_slt:
+    regs[op->rd] = (regs[op->rs1] < regs[op->rs2]) ? 1 : 0;
+    NEXT();
+do_sltu:
+    regs[op->rd] = (static_cast<uint32_t>(regs[op->rs1]) < static_cast<uint32_t>(regs[op->rs2])) ? 1 : 0;
+    NEXT();
+do_mulh:
+    regs[op->rd] = static_cast<int32_t>((static_cast<int64_t>(regs[op->rs1]) * regs[op->rs2]) >> 32);
+    NEXT();
+do_mulhsu:
+    regs[op->rd] = static_cast<int32_t>((static_cast<int64_t>(regs[op->rs1]) * static_cast<uint32_t>(regs[op->rs2])) >> 32);
+    NEXT();
+do_mulhu:
+    regs[op->rd] = static_cast<int32_t>((static_cast<uint64_t>(static_cast<uint32_t>(regs[op->rs1])) * static_cast<uint32_t>(regs[op->rs2])) >> 32);
+    NEXT();
+do_divu:
+    regs[op->rd] = (regs[op->rs2] == 0) ? -1 : static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) / static_cast<uint32_t>(regs[op->rs2]));
+    NEXT();
+do_remu:
+    regs[op->rd] = (regs[op->rs2] == 0) ? regs[op->rs1] : static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) % static_cast<uint32_t>(regs[op->rs2]));
+    NEXT();
+
+do_addi:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) + static_cast<uint32_t>(op->imm));
+    NEXT();
+do_andi:
+    regs[op->rd] = regs[op->rs1] & op->imm;
+    NEXT();
+do_ori:
+    regs[op->rd] = regs[op->rs1] | op->imm;
+    NEXT();
+do_xori:
+    regs[op->rd] = regs[op->rs1] ^ op->imm;
+    NEXT();
+do_slti:
+    regs[op->rd] = (regs[op->rs1] < op->imm) ? 1 : 0;
+    NEXT();
+do_sltiu:
+    regs[op->rd] = (static_cast<uint32_t>(regs[op->rs1]) < static_cast<uint32_t>(op->imm)) ? 1 : 0;
+    NEXT();
+do_slli:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) << op->imm);
+    NEXT();
+do_srli:
+    regs[op->rd] = static_cast<int32_t>(static_cast<uint32_t>(regs[op->rs1]) >> op->imm);
+    NEXT();
+do_srai:
+    regs[op->rd] = regs[op->rs1] >> op->imm;
+    NEXT();
+
+do_lb:
+    regs[op->rd] = static_cast<int8_t>(dataMemory.read8(EFFECTIVE_ADDRESS()));
+    NEXT();
+do_lh:
+    regs[op->rd] = static_cast<int16_t>(dataMemory.read16(EFFECTIVE_ADDRESS()));
+    NEXT();
+do_lw:
+    regs[op->rd] = static_cast<int32_t>(dataMemory.read32(EFFECTIVE_ADDRESS()));
+    NEXT();
+do_ld:
+    // Registers are 32 bits wide, so only the low word survives
+    regs[op->rd] = static_cast<int32_t>(dataMemory.read32(EFFECTIVE_ADDRESS()));
+    NEXT();
+do_lbu:
+    regs[op->rd] = dataMemory.read8(EFFECTIVE_ADDRESS());
+    NEXT();
+do_lhu:
+    regs[op->rd] = dataMemory.read16(EFFECTIVE_ADDRESS());
+    NEXT();
+
+do_sb:
+    dataMemory.write8(EFFECTIVE_ADDRESS(), regs[op->rs2]);
+    NEXT();
+do_sh:
+    dataMemory.write16(EFFECTIVE_ADDRESS(), regs[op->rs2]);
+    NEXT();
+do_sw:
+    dataMemory.write32(EFFECTIVE_ADDRESS(), regs[op->rs2]);
+    NEXT();
+do_sd:
+    dataMemory.write64(EFFECTIVE_ADDRESS(), static_cast<int64_t>(regs[op->rs2]));
+    NEXT();
+
+do_beq:
+    if (regs[op->rs1] == regs[op->rs2])
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+do_bne:
+    if (regs[op->rs1] != regs[op->rs2])
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+do_blt:
+    if (regs[op->rs1] < regs[op->rs2])
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+do_bge:
+    if (regs[op->rs1] >= regs[op->rs2])
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+do_bltu:
+    if (static_cast<uint32_t>(regs[op->rs1]) < static_cast<uint32_t>(regs[op->rs2]))
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+do_bgeu:
+    if (static_cast<uint32_t>(regs[op->rs1]) >= static_cast<uint32_t>(regs[op->rs2]))
+    {
+        JUMP_TO_TARGET();
+    }
+    NEXT();
+
+do_lui:
+    regs[op->rd] = op->imm;
+    NEXT();
+do_auipc:
+    regs[op->rd] = static_cast<int32_t>(PC_OF(op) + op->imm);
+    NEXT();
+do_jal:
+    regs[op->rd] = static_cast<int32_t>(PC_OF(op) + 4);
+    JUMP_TO_TARGET();
+do_jalr:
+{
+    // The target comes from rs1 before rd is written, as in jalr x1, x1, off
+    uint32_t from = PC_OF(op);
+    pc = (static_cast<uint32_t>(regs[op->rs1]) + op->imm) & ~1u;
+    regs[op->rd] = static_cast<int32_t>(from + 4);
+    if (pc == from)
+    {
+        infLoop = true;
+        goto leave;
+    }
+    uint32_t index = (pc - textBase) >> 2;
+    if (pc < textBase || (pc & 3) != 0 || index >= count)
+    {
+        goto leave;
+    }
+    op = ops.data() + index;
+    DISPATCH();
+}
+
+do_fence:
+    // One hart and no caches between it and memory: nothing to order
+    NEXT();
+
+do_exit:
+    // The exit instruction itself is not executed
+    exitSimulator = true;
+    executed--;
+    pc = PC_OF(op);
+    goto leave;
+
+do_stop:
+    executed--;
+    pc = PC_OF(op);
+    goto leave;
+
+#undef JUMP_TO_TARGET
+#undef NEXT
+#undef EFFECTIVE_ADDRESS
+#undef DISPATCH
+#undef PC_OF
+
+leave:
+    for (int i = 1; i < 32; i++)
+    {
+        registerFile[i] = regs[i];
+    }
+    currentPC = pc;
+    return executed;
+}
+
+void runFastFunctionalSimulation()
+{
+    // Setup the execution environment
+    resetSimulatorState();
+    initializeStack();
+    loadMC(input_file);
+    currentPC = entryPC;
+
+    uint64_t executed = runFastFunctional();
+    total_instructions = executed;
+    total_cycles = executed;
+
+    // Drain the trace before the final report
+    traceFlush();
+
+    for (int i = 0; i < 32; i++)
+    {
+        cout << "R" << i << ": " << registerFile[i] << endl;
+    }
+
+    cout << "\nFast functional run completed: " << executed << " instructions." << endl;
+
+    dumpMemoryToFile(output_file);
+}
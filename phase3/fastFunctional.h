@@ -0,0 +1,15 @@
+// fastFunctional.h
+#ifndef FASTFUNCTIONAL_H
+#define FASTFUNCTIONAL_H
+
+#include <cstdint>
+
+// Run the already loaded program with the predecoded threaded interpreter.
+// Architectural results match the non-pipelined model; nothing is printed
+// per instruction. Stops after maxInstructions. Returns instructions run.
+uint64_t runFastFunctional(uint64_t maxInstructions = UINT64_MAX);
+
+// Load input_file, run it in fast mode and dump registers and memory
+void runFastFunctionalSimulation();
+
+#endif // FASTFUNCTIONAL_H
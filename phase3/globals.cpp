@@ -1,59 +1,116 @@
-#include <bits/stdc++.h>
-#include "globals.h"
-
-using namespace std;
-
-// Execution state tracking
-map<string, string> pcMachineCode;
-string currentPC = "0x0";
-long long int result;
-string currentInstruction;
-int registerFile[32];
-bool infLoop = false;
-
-// Memory management variables
-unordered_map<unsigned int, unsigned char> dataMemory;
-unsigned int memoryBaseAddress = 0x10000000;
-unsigned int stackBaseAddress = 0x7FFFFFFC;
-unsigned int stackPointer = stackBaseAddress;
-unsigned int framePointer = stackBaseAddress;
-
-// Simulator control flags
-bool exitSimulator = false;
-bool knob_pipelining = true;
-bool knob_data_forwarding = true;
-bool knob_print_registers = false;
-bool knob_print_pipeline_registers = false;
-int knob_trace_instruction = -1;
-bool knob_print_branch_predictor = false;
-
-// Performance statistics
-int total_cycles = 0;
-int total_instructions = 0;
-int data_transfer_instructions = 0;
-int alu_instructions = 0;
-int control_instructions = 0;
-int pipeline_stalls = 0;
-int data_hazards = 0;
-int control_hazards = 0;
-int branch_mispredictions = 0;
-int stalls_data_hazards = 0;
-int stalls_control_hazards = 0;
-
-// Pipeline components
-Instruction instruction;
-IF_ID_Register if_id;
-ID_EX_Register id_ex;
-EX_MEM_Register ex_mem;
-MEM_WB_Register mem_wb;
-BranchPredictor branchPredictor;
-
-// Memory model and branch prediction
-unordered_map<int, int> memory;
-bool predicted_branch;
-string predicted_pc;
-
-// File paths
-string input_file = "input.mc";
-string output_file = "output.mc";
-string stats_file = "stats.txt";
+#include <bits/stdc++.h>
+#include "globals.h"
+#include "hazards.h"
+#include "stats.h"
+#include "elfLoader.h"
+
+using namespace std;
+
+// Program image
+thread_local vector<uint32_t> textSegment;
+__constinit thread_local const uint32_t *textData = nullptr;
+__constinit thread_local uint32_t textWordCount = 0;
+__constinit thread_local uint32_t textBase = 0;
+__constinit thread_local uint32_t entryPC = 0;
+
+// Execution state tracking
+__constinit thread_local uint32_t currentPC = 0;
+__constinit thread_local long long int result;
+__constinit thread_local uint32_t currentInstruction;
+__constinit thread_local int registerFile[32];
+__constinit thread_local bool infLoop = false;
+
+// Memory management variables
+thread_local PagedMemory dataMemory;
+__constinit thread_local unsigned int memoryBaseAddress = 0x10000000;
+__constinit thread_local unsigned int stackBaseAddress = 0x7FFFFFFC;
+__constinit thread_local unsigned int stackPointer = 0x7FFFFFFC;
+__constinit thread_local unsigned int framePointer = 0x7FFFFFFC;
+
+// Simulator control flags
+__constinit thread_local bool exitSimulator = false;
+__constinit thread_local bool knob_pipelining = true;
+__constinit thread_local bool knob_data_forwarding = true;
+__constinit thread_local bool knob_print_registers = false;
+__constinit thread_local bool knob_print_pipeline_registers = false;
+__constinit thread_local int knob_trace_instruction = -1;
+__constinit thread_local bool knob_print_branch_predictor = false;
+__constinit thread_local bool knob_cache = false;
+__constinit thread_local PredictorKind knob_branch_predictor = PredictorKind::OneBit;
+__constinit thread_local bool knob_branch_profile = false;
+
+// Performance statistics
+__constinit thread_local int total_cycles = 0;
+__constinit thread_local int total_instructions = 0;
+__constinit thread_local int data_transfer_instructions = 0;
+__constinit thread_local int alu_instructions = 0;
+__constinit thread_local int control_instructions = 0;
+__constinit thread_local int pipeline_stalls = 0;
+__constinit thread_local int data_hazards = 0;
+__constinit thread_local int control_hazards = 0;
+__constinit thread_local int branch_mispredictions = 0;
+__constinit thread_local int stalls_data_hazards = 0;
+__constinit thread_local int stalls_control_hazards = 0;
+__constinit thread_local int stalls_fetch_misses = 0;
+__constinit thread_local int stalls_memory_misses = 0;
+
+// Pipeline components
+__constinit thread_local Instruction instruction;
+__constinit thread_local IF_ID_Register if_id;
+__constinit thread_local ID_EX_Register id_ex;
+__constinit thread_local EX_MEM_Register ex_mem;
+__constinit thread_local MEM_WB_Register mem_wb;
+thread_local BranchPredictor branchPredictor;
+thread_local std::unordered_map<uint32_t, BranchCounts> branchProfile;
+
+// Cache hierarchy timing model
+thread_local CacheHierarchy cacheHierarchy;
+
+// Branch prediction
+__constinit thread_local bool predicted_branch;
+__constinit thread_local uint32_t predicted_pc = 0;
+
+// File paths
+thread_local string input_file = "input.mc";
+thread_local string output_file = "output.mc";
+thread_local string stats_file = "pipeline_stats.txt";
+
+void resetSimulatorState()
+{
+    // Program image and architectural state
+    textSegment.clear();
+    textData = nullptr;
+    textWordCount = 0;
+    textBase = 0;
+    entryPC = 0;
+    programSymbols.clear();
+    currentPC = 0;
+    result = 0;
+    currentInstruction = 0;
+    for (int i = 0; i < 32; i++)
+    {
+        registerFile[i] = 0;
+    }
+    infLoop = false;
+    exitSimulator = false;
+
+    // Memory and stack
+    dataMemory.clear();
+    stackPointer = stackBaseAddress;
+    framePointer = stackBaseAddress;
+
+    // Pipeline, prediction and caches
+    instruction = Instruction();
+    if_id = IF_ID_Register();
+    id_ex = ID_EX_Register();
+    ex_mem = EX_MEM_Register();
+    mem_wb = MEM_WB_Register();
+    branchPredictor = BranchPredictor(knob_branch_predictor);
+    branchProfile.clear();
+    predicted_branch = false;
+    predicted_pc = 0;
+    cacheHierarchy.reset();
+    resetHazardUnit();
+
+    initializeStats();
+}
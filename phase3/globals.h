@@ -1,65 +1,112 @@
-// globals.h
-#ifndef GLOBALS_H
-#define GLOBALS_H
-
-#include <string>
-#include <map>
-#include <unordered_map>
-#include "structs.h"
-
-// Program counter and instruction tracking
-extern std::map<std::string, std::string> pcMachineCode;
-extern std::string currentPC;
-extern long long int result;
-extern std::string currentInstruction;
-extern int registerFile[32];
-extern bool infLoop;
-
-// Memory management
-extern std::unordered_map<unsigned int, unsigned char> dataMemory;
-extern unsigned int memoryBaseAddress;
-extern unsigned int stackBaseAddress;
-extern unsigned int stackPointer;
-extern unsigned int framePointer;
-
-// Simulator control flags
-extern bool exitSimulator;
-extern bool knob_pipelining;
-extern bool knob_data_forwarding;
-extern bool knob_print_registers;
-extern bool knob_print_pipeline_registers;
-extern int knob_trace_instruction;
-extern bool knob_print_branch_predictor;
-
-// Performance metrics
-extern int total_cycles;
-extern int total_instructions;
-extern int data_transfer_instructions;
-extern int alu_instructions;
-extern int control_instructions;
-extern int pipeline_stalls;
-extern int data_hazards;
-extern int control_hazards;
-extern int branch_mispredictions;
-extern int stalls_data_hazards;
-extern int stalls_control_hazards;
-
-// Pipeline components
-extern Instruction instruction;
-extern IF_ID_Register if_id;
-extern ID_EX_Register id_ex;
-extern EX_MEM_Register ex_mem;
-extern MEM_WB_Register mem_wb;
-extern BranchPredictor branchPredictor;
-
-// Memory model and branch prediction
-extern std::unordered_map<int, int> memory;
-extern bool predicted_branch;
-extern std::string predicted_pc;
-
-// File paths
-extern std::string input_file;
-extern std::string output_file;
-extern std::string stats_file;
-
-#endif // GLOBALS_H
+// globals.h
+#ifndef GLOBALS_H
+#define GLOBALS_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "structs.h"
+#include "pagedMemory.h"
+#include "cache.h"
+
+// All simulator state is thread_local, so each thread runs an independent
+// simulation. Plain values are marked __constinit: other translation units
+// then reach them directly instead of calling a TLS init wrapper on every
+// access. Objects with constructors (vectors, memory, predictor, caches)
+// cannot be, and are kept off the per-cycle paths where possible.
+
+// Program image: text segment words indexed by (pc - textBase) >> 2.
+// An all-zero word is not a valid RV32 encoding and marks a hole.
+extern thread_local std::vector<uint32_t> textSegment;
+extern __constinit thread_local const uint32_t *textData; // textSegment.data() for the fetch path
+extern __constinit thread_local uint32_t textWordCount;   // textSegment.size()
+extern __constinit thread_local uint32_t textBase;
+extern __constinit thread_local uint32_t entryPC; // Where execution starts: e_entry, or textBase for .mc
+
+// Program counter and instruction tracking
+extern __constinit thread_local uint32_t currentPC;
+extern __constinit thread_local long long int result;
+extern __constinit thread_local uint32_t currentInstruction;
+extern __constinit thread_local int registerFile[32];
+extern __constinit thread_local bool infLoop;
+
+// Memory management
+extern thread_local PagedMemory dataMemory;
+extern __constinit thread_local unsigned int memoryBaseAddress;
+extern __constinit thread_local unsigned int stackBaseAddress;
+extern __constinit thread_local unsigned int stackPointer;
+extern __constinit thread_local unsigned int framePointer;
+
+// Simulator control flags
+extern __constinit thread_local bool exitSimulator;
+extern __constinit thread_local bool knob_pipelining;
+extern __constinit thread_local bool knob_data_forwarding;
+extern __constinit thread_local bool knob_print_registers;
+extern __constinit thread_local bool knob_print_pipeline_registers;
+extern __constinit thread_local int knob_trace_instruction;
+extern __constinit thread_local bool knob_print_branch_predictor;
+extern __constinit thread_local bool knob_cache;
+extern __constinit thread_local PredictorKind knob_branch_predictor;
+extern __constinit thread_local bool knob_branch_profile;
+
+// Performance metrics
+extern __constinit thread_local int total_cycles;
+extern __constinit thread_local int total_instructions;
+extern __constinit thread_local int data_transfer_instructions;
+extern __constinit thread_local int alu_instructions;
+extern __constinit thread_local int control_instructions;
+extern __constinit thread_local int pipeline_stalls;
+extern __constinit thread_local int data_hazards;
+extern __constinit thread_local int control_hazards;
+extern __constinit thread_local int branch_mispredictions;
+extern __constinit thread_local int stalls_data_hazards;
+extern __constinit thread_local int stalls_control_hazards;
+extern __constinit thread_local int stalls_fetch_misses;
+extern __constinit thread_local int stalls_memory_misses;
+
+// Pipeline components
+extern __constinit thread_local Instruction instruction;
+extern __constinit thread_local IF_ID_Register if_id;
+extern __constinit thread_local ID_EX_Register id_ex;
+extern __constinit thread_local EX_MEM_Register ex_mem;
+extern __constinit thread_local MEM_WB_Register mem_wb;
+extern thread_local BranchPredictor branchPredictor;
+
+// Per-branch outcomes by PC, recorded when knob_branch_profile is set
+extern thread_local std::unordered_map<uint32_t, BranchCounts> branchProfile;
+
+// Cache hierarchy timing model, consulted by IF and MEM when knob_cache is set
+extern thread_local CacheHierarchy cacheHierarchy;
+
+// Branch prediction
+extern __constinit thread_local bool predicted_branch;
+extern __constinit thread_local uint32_t predicted_pc;
+
+// File paths
+extern thread_local std::string input_file;
+extern thread_local std::string output_file;
+extern thread_local std::string stats_file;
+
+// Return every piece of per-run state (registers, memory, program image,
+// pipeline registers, predictor, caches, hazard unit, counters) to its
+// power-on value. Knobs and file paths are left alone.
+void resetSimulatorState();
+
+// Returns the instruction word at pc, or 0 if pc is outside the text segment
+inline uint32_t instructionAt(uint32_t pc)
+{
+    uint32_t index = (pc - textBase) >> 2;
+    if (pc < textBase || (pc & 3) != 0 || index >= textWordCount)
+    {
+        return 0;
+    }
+    return textData[index];
+}
+
+// True if pc addresses a loaded instruction
+inline bool isValidPC(uint32_t pc)
+{
+    return instructionAt(pc) != 0;
+}
+
+#endif // GLOBALS_H
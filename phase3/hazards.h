@@ -1,26 +1,34 @@
-#ifndef HAZARDS_H
-#define HAZARDS_H
-
-#include "structs.h"
-
-// Pipeline control flags for stalls and flushes
-extern bool stall_fetch;
-extern bool stall_decode;
-extern bool stall_execute;
-extern bool stall_memory;
-extern bool stall_writeback;
-
-extern bool flush_fetch;
-extern bool flush_decode;
-extern bool flush_execute;
-extern bool flush_memory;
-
-// Function declarations for hazard detection and handling
-void detectAndHandleHazards();
-bool detectDataHazard();
-bool detectControlHazard();
-void insertStall(int stageNum);
-void handleDataForwarding();
-bool checkForwardingPath(int source_reg, int dest_reg, int pipeline_stage);
-
-#endif // HAZARDS_H
+#ifndef HAZARDS_H
+#define HAZARDS_H
+
+#include "structs.h"
+
+// Pipeline control flags for stalls and flushes
+extern __constinit thread_local bool stall_fetch;
+extern __constinit thread_local bool stall_decode;
+extern __constinit thread_local bool stall_execute;
+extern __constinit thread_local bool stall_memory;
+extern __constinit thread_local bool stall_writeback;
+
+extern __constinit thread_local bool flush_fetch;
+extern __constinit thread_local bool flush_decode;
+extern __constinit thread_local bool flush_execute;
+extern __constinit thread_local bool flush_memory;
+
+// Outstanding cache misses
+extern __constinit thread_local uint32_t fetch_miss_cycles;   // Cycles until the pending fetch returns
+extern __constinit thread_local uint32_t fetch_miss_pc;       // Address of the pending fetch
+extern __constinit thread_local bool fetch_miss_pending;      // IF is waiting on the instruction cache
+extern __constinit thread_local uint32_t memory_miss_cycles;  // Cycles MEM stays frozen on a data miss
+extern __constinit thread_local bool memory_miss_served;      // The access in EX/MEM already paid its miss
+
+// Function declarations for hazard detection and handling
+void resetHazardUnit();
+void detectAndHandleHazards();
+bool detectDataHazard();
+bool detectControlHazard();
+void insertStall(int stageNum);
+void handleDataForwarding();
+bool checkForwardingPath(int source_reg, int dest_reg, int pipeline_stage);
+
+#endif // HAZARDS_H
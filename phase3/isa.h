@@ -0,0 +1,443 @@
+// isa.h
+// Single RV32 instruction table shared by the assembler (phase1) and the
+// simulators (phase2, phase3). Encoders, the mask/match decoder and the
+// executor mnemonic IDs are all derived from isaTable below, so adding an
+// instruction means adding one row here plus its execute semantics.
+#ifndef ISA_H
+#define ISA_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Instruction format type (None marks an empty pipeline slot)
+enum class InstType : uint8_t
+{
+    None,
+    R,
+    I,
+    Load,
+    S,
+    SB,
+    LUI,
+    AUIPC,
+    JAL,
+    JALR,
+    Unknown
+};
+
+// Functional class used for the instruction-mix statistics
+enum class InstClass : uint8_t
+{
+    None,
+    ALU,
+    DataTransfer,
+    Control
+};
+
+// Mnemonic ID
+enum class Mnemonic : uint8_t
+{
+    NOP,
+    ADD, SUB, MUL, DIV, REM, AND, OR, XOR, SLL, SRL, SRA, SLT,
+    SLTU, MULH, MULHSU, MULHU, DIVU, REMU,
+    ADDI, ANDI, ORI, XORI, SLTI, SLTIU, SLLI, SRLI, SRAI,
+    LB, LH, LW, LD, LBU, LHU,
+    SB, SH, SW, SD,
+    BEQ, BNE, BLT, BGE, BLTU, BGEU,
+    LUI, AUIPC, JAL, JALR,
+    FENCE, ECALL, EBREAK,
+    UNKNOWN
+};
+
+// Assembly operand layout
+enum class OperandLayout : uint8_t
+{
+    RdRs1Rs2,     // add rd rs1 rs2
+    RdRs1Imm,     // addi rd rs1 imm / jalr rd rs1 imm
+    RdMem,        // lw rd imm(rs1)
+    Rs2Mem,       // sw rs2 imm(rs1)
+    Rs1Rs2Target, // beq rs1 rs2 label
+    RdUpper,      // lui rd imm20
+    RdTarget,     // jal rd label
+    None          // ecall, ebreak, fence (optional iorw sets)
+};
+
+// Rough execution cost, used by timing models and the assembler scheduler
+enum class LatencyClass : uint8_t
+{
+    Single,
+    Load,
+    Store,
+    Multiply,
+    Divide,
+    Branch
+};
+
+struct IsaEntry
+{
+    const char *asmName;  // Assembler mnemonic
+    Mnemonic id;          // Executor mnemonic ID
+    InstType type;        // Encoding format
+    OperandLayout layout; // Assembly operand order
+    uint32_t mask;        // Bits that identify the instruction
+    uint32_t match;       // Value of those bits
+    InstClass iclass;     // Statistics class
+    LatencyClass latency; // Execution cost class
+};
+
+// Mask for each format's fixed fields
+constexpr uint32_t MASK_OPCODE = 0x0000007F;
+constexpr uint32_t MASK_FUNCT3 = 0x0000707F;
+constexpr uint32_t MASK_FUNCT7 = 0xFE00707F;
+constexpr uint32_t MASK_WORD = 0xFFFFFFFF;
+
+constexpr uint32_t rvMatch(uint32_t opcode, uint32_t funct3 = 0, uint32_t funct7 = 0)
+{
+    return opcode | (funct3 << 12) | (funct7 << 25);
+}
+
+// clang-format off
+constexpr IsaEntry isaTable[] = {
+    // R-type
+    {"add",    Mnemonic::ADD,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x0, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"sub",    Mnemonic::SUB,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x0, 0x20),   InstClass::ALU,          LatencyClass::Single},
+    {"sll",    Mnemonic::SLL,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x1, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"slt",    Mnemonic::SLT,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x2, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"sltu",   Mnemonic::SLTU,   InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x3, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"xor",    Mnemonic::XOR,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x4, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"srl",    Mnemonic::SRL,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x5, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"sra",    Mnemonic::SRA,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x5, 0x20),   InstClass::ALU,          LatencyClass::Single},
+    {"or",     Mnemonic::OR,     InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x6, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"and",    Mnemonic::AND,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x7, 0x00),   InstClass::ALU,          LatencyClass::Single},
+
+    // M extension
+    {"mul",    Mnemonic::MUL,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x0, 0x01),   InstClass::ALU,          LatencyClass::Multiply},
+    {"mulh",   Mnemonic::MULH,   InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x1, 0x01),   InstClass::ALU,          LatencyClass::Multiply},
+    {"mulhsu", Mnemonic::MULHSU, InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x2, 0x01),   InstClass::ALU,          LatencyClass::Multiply},
+    {"mulhu",  Mnemonic::MULHU,  InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x3, 0x01),   InstClass::ALU,          LatencyClass::Multiply},
+    {"div",    Mnemonic::DIV,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x4, 0x01),   InstClass::ALU,          LatencyClass::Divide},
+    {"divu",   Mnemonic::DIVU,   InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x5, 0x01),   InstClass::ALU,          LatencyClass::Divide},
+    {"rem",    Mnemonic::REM,    InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x6, 0x01),   InstClass::ALU,          LatencyClass::Divide},
+    {"remu",   Mnemonic::REMU,   InstType::R,     OperandLayout::RdRs1Rs2,     MASK_FUNCT7, rvMatch(0x33, 0x7, 0x01),   InstClass::ALU,          LatencyClass::Divide},
+
+    // I-type arithmetic
+    {"addi",   Mnemonic::ADDI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x0),         InstClass::ALU,          LatencyClass::Single},
+    {"slti",   Mnemonic::SLTI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x2),         InstClass::ALU,          LatencyClass::Single},
+    {"sltiu",  Mnemonic::SLTIU,  InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x3),         InstClass::ALU,          LatencyClass::Single},
+    {"xori",   Mnemonic::XORI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x4),         InstClass::ALU,          LatencyClass::Single},
+    {"ori",    Mnemonic::ORI,    InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x6),         InstClass::ALU,          LatencyClass::Single},
+    {"andi",   Mnemonic::ANDI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x13, 0x7),         InstClass::ALU,          LatencyClass::Single},
+
+    // Shifts by an immediate: funct7 fills the upper bits of the immediate
+    {"slli",   Mnemonic::SLLI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT7, rvMatch(0x13, 0x1, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"srli",   Mnemonic::SRLI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT7, rvMatch(0x13, 0x5, 0x00),   InstClass::ALU,          LatencyClass::Single},
+    {"srai",   Mnemonic::SRAI,   InstType::I,     OperandLayout::RdRs1Imm,     MASK_FUNCT7, rvMatch(0x13, 0x5, 0x20),   InstClass::ALU,          LatencyClass::Single},
+
+    // Loads
+    {"lb",     Mnemonic::LB,     InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x0),         InstClass::DataTransfer, LatencyClass::Load},
+    {"lh",     Mnemonic::LH,     InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x1),         InstClass::DataTransfer, LatencyClass::Load},
+    {"lw",     Mnemonic::LW,     InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x2),         InstClass::DataTransfer, LatencyClass::Load},
+    {"ld",     Mnemonic::LD,     InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x3),         InstClass::DataTransfer, LatencyClass::Load},
+    {"lbu",    Mnemonic::LBU,    InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x4),         InstClass::DataTransfer, LatencyClass::Load},
+    {"lhu",    Mnemonic::LHU,    InstType::Load,  OperandLayout::RdMem,        MASK_FUNCT3, rvMatch(0x03, 0x5),         InstClass::DataTransfer, LatencyClass::Load},
+
+    // Stores
+    {"sb",     Mnemonic::SB,     InstType::S,     OperandLayout::Rs2Mem,       MASK_FUNCT3, rvMatch(0x23, 0x0),         InstClass::DataTransfer, LatencyClass::Store},
+    {"sh",     Mnemonic::SH,     InstType::S,     OperandLayout::Rs2Mem,       MASK_FUNCT3, rvMatch(0x23, 0x1),         InstClass::DataTransfer, LatencyClass::Store},
+    {"sw",     Mnemonic::SW,     InstType::S,     OperandLayout::Rs2Mem,       MASK_FUNCT3, rvMatch(0x23, 0x2),         InstClass::DataTransfer, LatencyClass::Store},
+    {"sd",     Mnemonic::SD,     InstType::S,     OperandLayout::Rs2Mem,       MASK_FUNCT3, rvMatch(0x23, 0x3),         InstClass::DataTransfer, LatencyClass::Store},
+
+    // Branches
+    {"beq",    Mnemonic::BEQ,    InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x0),         InstClass::Control,      LatencyClass::Branch},
+    {"bne",    Mnemonic::BNE,    InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x1),         InstClass::Control,      LatencyClass::Branch},
+    {"blt",    Mnemonic::BLT,    InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x4),         InstClass::Control,      LatencyClass::Branch},
+    {"bge",    Mnemonic::BGE,    InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x5),         InstClass::Control,      LatencyClass::Branch},
+    {"bltu",   Mnemonic::BLTU,   InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x6),         InstClass::Control,      LatencyClass::Branch},
+    {"bgeu",   Mnemonic::BGEU,   InstType::SB,    OperandLayout::Rs1Rs2Target, MASK_FUNCT3, rvMatch(0x63, 0x7),         InstClass::Control,      LatencyClass::Branch},
+
+    // Upper immediates and jumps
+    {"lui",    Mnemonic::LUI,    InstType::LUI,   OperandLayout::RdUpper,      MASK_OPCODE, rvMatch(0x37),              InstClass::ALU,          LatencyClass::Single},
+    {"auipc",  Mnemonic::AUIPC,  InstType::AUIPC, OperandLayout::RdUpper,      MASK_OPCODE, rvMatch(0x17),              InstClass::ALU,          LatencyClass::Single},
+    {"jal",    Mnemonic::JAL,    InstType::JAL,   OperandLayout::RdTarget,     MASK_OPCODE, rvMatch(0x6F),              InstClass::Control,      LatencyClass::Branch},
+    {"jalr",   Mnemonic::JALR,   InstType::JALR,  OperandLayout::RdRs1Imm,     MASK_FUNCT3, rvMatch(0x67, 0x0),         InstClass::Control,      LatencyClass::Branch},
+
+    // System: fence orders memory (a no-op for one in-order hart); ecall and
+    // ebreak end the program like addi x0, x0, 1
+    {"fence",  Mnemonic::FENCE,  InstType::I,     OperandLayout::None,         MASK_FUNCT3, rvMatch(0x0F, 0x0),         InstClass::DataTransfer, LatencyClass::Single},
+    {"ecall",  Mnemonic::ECALL,  InstType::I,     OperandLayout::None,         MASK_WORD,   rvMatch(0x73),              InstClass::Control,      LatencyClass::Branch},
+    {"ebreak", Mnemonic::EBREAK, InstType::I,     OperandLayout::None,         MASK_WORD,   rvMatch(0x73) | (1u << 20), InstClass::Control,      LatencyClass::Branch},
+};
+// clang-format on
+
+constexpr size_t isaTableSize = sizeof(isaTable) / sizeof(isaTable[0]);
+
+// Which register fields an operand layout uses
+constexpr bool layoutWritesRd(OperandLayout layout)
+{
+    return layout != OperandLayout::Rs2Mem && layout != OperandLayout::Rs1Rs2Target && layout != OperandLayout::None;
+}
+
+constexpr bool layoutReadsRs1(OperandLayout layout)
+{
+    return layout != OperandLayout::RdUpper && layout != OperandLayout::RdTarget && layout != OperandLayout::None;
+}
+
+constexpr bool layoutReadsRs2(OperandLayout layout)
+{
+    return layout == OperandLayout::RdRs1Rs2 || layout == OperandLayout::Rs2Mem ||
+           layout == OperandLayout::Rs1Rs2Target;
+}
+
+// slli, srli and srai: I-type with funct7 in the immediate's upper bits,
+// leaving 5 bits for the shift amount
+constexpr bool isaShiftImmediate(const IsaEntry &entry)
+{
+    return entry.type == InstType::I && entry.mask == MASK_FUNCT7;
+}
+
+// Register field extraction
+constexpr uint32_t rdField(uint32_t word) { return (word >> 7) & 0x1F; }
+constexpr uint32_t rs1Field(uint32_t word) { return (word >> 15) & 0x1F; }
+constexpr uint32_t rs2Field(uint32_t word) { return (word >> 20) & 0x1F; }
+
+// Sign-extend the low `bits` bits of value
+constexpr int32_t signExtend(uint32_t value, int bits)
+{
+    return static_cast<int32_t>(value << (32 - bits)) >> (32 - bits);
+}
+
+// Sign-extended immediate of an encoded instruction. U-type immediates are
+// returned already shifted into bits 31:12.
+constexpr int32_t isaImmediate(InstType type, uint32_t word)
+{
+    switch (type)
+    {
+    case InstType::I:
+    case InstType::Load:
+    case InstType::JALR:
+        return signExtend(word >> 20, 12);
+    case InstType::S:
+        return signExtend(((word >> 25) << 5) | ((word >> 7) & 0x1F), 12);
+    case InstType::SB:
+        return signExtend(((word >> 31) << 12) | (((word >> 7) & 0x1) << 11) |
+                              (((word >> 25) & 0x3F) << 5) | (((word >> 8) & 0xF) << 1),
+                          13);
+    case InstType::LUI:
+    case InstType::AUIPC:
+        return static_cast<int32_t>(word & 0xFFFFF000);
+    case InstType::JAL:
+        return signExtend(((word >> 31) << 20) | (((word >> 12) & 0xFF) << 12) |
+                              (((word >> 20) & 0x1) << 11) | (((word >> 21) & 0x3FF) << 1),
+                          21);
+    default:
+        return 0;
+    }
+}
+
+// Encode one instruction. imm is the byte offset for branches and jumps and
+// the 20-bit field value for LUI/AUIPC.
+constexpr uint32_t isaEncode(const IsaEntry &entry, uint32_t rd, uint32_t rs1, uint32_t rs2, int32_t imm)
+{
+    uint32_t u = static_cast<uint32_t>(imm);
+    uint32_t word = entry.match;
+    switch (entry.type)
+    {
+    case InstType::R:
+        return word | (rd << 7) | (rs1 << 15) | (rs2 << 20);
+    case InstType::I:
+    case InstType::Load:
+    case InstType::JALR:
+        return word | (rd << 7) | (rs1 << 15) | ((u & 0xFFF) << 20);
+    case InstType::S:
+        return word | ((u & 0x1F) << 7) | (rs1 << 15) | (rs2 << 20) | (((u >> 5) & 0x7F) << 25);
+    case InstType::SB:
+        return word | (((u >> 11) & 0x1) << 7) | (((u >> 1) & 0xF) << 8) | (rs1 << 15) | (rs2 << 20) |
+               (((u >> 5) & 0x3F) << 25) | (((u >> 12) & 0x1) << 31);
+    case InstType::LUI:
+    case InstType::AUIPC:
+        return word | (rd << 7) | ((u & 0xFFFFF) << 12);
+    case InstType::JAL:
+        return word | (rd << 7) | (((u >> 12) & 0xFF) << 12) | (((u >> 11) & 0x1) << 20) |
+               (((u >> 1) & 0x3FF) << 21) | (((u >> 20) & 0x1) << 31);
+    default:
+        return 0;
+    }
+}
+
+// Decode index: for every opcode[6:2]/funct3 pair, up to four table rows
+// whose fixed bits agree with it. Built at compile time from isaTable.
+constexpr int ISA_DECODE_WAYS = 4;
+constexpr uint8_t ISA_NO_ENTRY = 0xFF;
+
+struct IsaDecodeIndex
+{
+    uint8_t slot[256][ISA_DECODE_WAYS];
+};
+
+constexpr uint32_t isaDecodeKey(uint32_t word)
+{
+    return (((word >> 2) & 0x1F) << 3) | ((word >> 12) & 0x7);
+}
+
+constexpr IsaDecodeIndex buildIsaDecodeIndex()
+{
+    IsaDecodeIndex index{};
+    for (uint32_t key = 0; key < 256; key++)
+    {
+        for (int way = 0; way < ISA_DECODE_WAYS; way++)
+        {
+            index.slot[key][way] = ISA_NO_ENTRY;
+        }
+
+        // Representative word carrying just the key bits
+        uint32_t word = ((key >> 3) << 2) | 0x3 | ((key & 0x7) << 12);
+        uint32_t keyMask = 0x7F | (0x7 << 12);
+        int used = 0;
+        for (size_t e = 0; e < isaTableSize; e++)
+        {
+            if (((word ^ isaTable[e].match) & isaTable[e].mask & keyMask) == 0)
+            {
+                if (used == ISA_DECODE_WAYS)
+                {
+                    throw "isaTable: too many rows share one opcode/funct3 pair";
+                }
+                index.slot[key][used++] = static_cast<uint8_t>(e);
+            }
+        }
+    }
+    return index;
+}
+
+constexpr IsaDecodeIndex isaDecodeIndex = buildIsaDecodeIndex();
+
+// Mask-and-match lookup; nullptr if the word is not a known instruction
+constexpr const IsaEntry *isaDecode(uint32_t word)
+{
+    if ((word & 0x3) != 0x3)
+    {
+        return nullptr;
+    }
+    const uint8_t *ways = isaDecodeIndex.slot[isaDecodeKey(word)];
+    for (int way = 0; way < ISA_DECODE_WAYS && ways[way] != ISA_NO_ENTRY; way++)
+    {
+        const IsaEntry &entry = isaTable[ways[way]];
+        if ((word & entry.mask) == entry.match)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+// Compile-time perfect hash over a table of names. buildNameIndex() searches
+// for a seed under which every row lands in its own slot, so a lookup is one
+// hash, one slot read and one string compare. SLOTS must be a power of two.
+constexpr uint8_t NAME_NO_ROW = 0xFF;
+
+template <size_t SLOTS>
+struct NameIndex
+{
+    uint32_t seed;
+    uint8_t row[SLOTS];
+};
+
+// Seeded FNV-1a with the high half folded into the slot bits
+constexpr uint32_t nameHash(const char *text, size_t length, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(text[i])) * 16777619u;
+    }
+    return hash ^ (hash >> 16);
+}
+
+constexpr size_t nameLength(const char *text)
+{
+    size_t length = 0;
+    while (text[length] != '\0')
+    {
+        length++;
+    }
+    return length;
+}
+
+template <size_t SLOTS, typename Row, size_t N>
+constexpr NameIndex<SLOTS> buildNameIndex(const Row (&rows)[N], const char *const Row::*name)
+{
+    static_assert((SLOTS & (SLOTS - 1)) == 0, "slot count must be a power of two");
+    static_assert(N < NAME_NO_ROW && N <= SLOTS, "too many names for the index");
+    for (uint32_t seed = 0;; seed++)
+    {
+        NameIndex<SLOTS> index{};
+        index.seed = seed;
+        for (size_t s = 0; s < SLOTS; s++)
+        {
+            index.row[s] = NAME_NO_ROW;
+        }
+        size_t r = 0;
+        for (; r < N; r++)
+        {
+            const char *text = rows[r].*name;
+            uint8_t &slot = index.row[nameHash(text, nameLength(text), seed) & (SLOTS - 1)];
+            if (slot != NAME_NO_ROW)
+            {
+                break;
+            }
+            slot = static_cast<uint8_t>(r);
+        }
+        if (r == N)
+        {
+            return index;
+        }
+    }
+}
+
+// Row whose name is exactly text[0, length); nullptr if there is none
+template <size_t SLOTS, typename Row, size_t N>
+constexpr const Row *nameLookup(const NameIndex<SLOTS> &index, const Row (&rows)[N], const char *const Row::*name,
+                                const char *text, size_t length)
+{
+    uint8_t r = index.row[nameHash(text, length, index.seed) & (SLOTS - 1)];
+    if (r == NAME_NO_ROW)
+    {
+        return nullptr;
+    }
+    const char *candidate = rows[r].*name;
+    for (size_t i = 0; i < length; i++)
+    {
+        if (candidate[i] == '\0' || candidate[i] != text[i])
+        {
+            return nullptr;
+        }
+    }
+    return candidate[length] == '\0' ? &rows[r] : nullptr;
+}
+
+constexpr NameIndex<256> isaNameIndex = buildNameIndex<256>(isaTable, &IsaEntry::asmName);
+
+// Lookup by assembler mnemonic; nullptr if unknown
+constexpr const IsaEntry *isaFind(const char *asmName, size_t length)
+{
+    return nameLookup(isaNameIndex, isaTable, &IsaEntry::asmName, asmName, length);
+}
+
+constexpr const IsaEntry *isaFind(const char *asmName)
+{
+    return isaFind(asmName, nameLength(asmName));
+}
+
+// Encoder and decoder must agree on every format
+static_assert(isaDecode(0x002080B3)->id == Mnemonic::ADD, "add x1 x1 x2");
+static_assert(isaDecode(isaEncode(*isaFind("sub"), 8, 8, 9, 0))->id == Mnemonic::SUB, "sub round trip");
+static_assert(isaDecode(isaEncode(*isaFind("srai"), 5, 6, 0, 31))->id == Mnemonic::SRAI, "srai round trip");
+static_assert(isaDecode(isaEncode(*isaFind("srli"), 5, 6, 0, 31))->id == Mnemonic::SRLI, "srli round trip");
+static_assert(isaDecode(0x00100073)->id == Mnemonic::EBREAK && isaDecode(0x00000073)->id == Mnemonic::ECALL, "ebreak, ecall");
+static_assert(isaDecode(0x0FF0000F)->id == Mnemonic::FENCE, "fence iorw, iorw");
+static_assert(isaImmediate(InstType::SB, isaEncode(*isaFind("beq"), 0, 6, 7, -4096)) == -4096, "branch immediate");
+static_assert(isaImmediate(InstType::JAL, isaEncode(*isaFind("jal"), 1, 0, 0, -44)) == -44, "jal immediate");
+static_assert(isaImmediate(InstType::S, isaEncode(*isaFind("sh"), 0, 31, 30, -16)) == -16, "store immediate");
+static_assert(isaFind("jalr")->id == Mnemonic::JALR && isaFind("jal")->id == Mnemonic::JAL, "mnemonic index");
+static_assert(isaFind("ja") == nullptr && isaFind("addi ", 4)->id == Mnemonic::ADDI, "mnemonic index");
+
+#endif // ISA_H
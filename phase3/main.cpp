@@ -0,0 +1,446 @@
+#include <bits/stdc++.h>
+#include "globals.h"
+#include "batch.h"
+#include "cache.h"
+#include "elfLoader.h"
+#include "fastFunctional.h"
+#include "nonPipelined.h"
+#include "pipelined.h"
+#include "stack.h"
+#include "stats.h"
+#include "trace.h"
+#include "utils.h"
+
+using namespace std;
+
+// rvsim: command-line driver for the phase 3 simulator
+
+static void printUsage(ostream &out)
+{
+    out << "Usage: rvsim [options] [input.mc]\n"
+           "\n"
+           "Simulation:\n"
+           "  -m, --mode MODE            pipelined (default), functional or fast\n"
+           "  -i, --input FILE           Program to load (default input.mc)\n"
+           "  -o, --output FILE          Data memory dump (default output.mc)\n"
+           "  -s, --stats FILE           Statistics file (default pipeline_stats.txt)\n"
+           "      --max-cycles N         Stop after N cycles\n"
+           "      --max-insts N          Stop after N instructions\n"
+           "  -q, --quiet                Print only the final statistics\n"
+           "      --profile FILE         Write taken/not-taken counts per branch to FILE,\n"
+           "                             for the assembler's --profile (not in fast mode)\n"
+           "\n"
+           "Pipeline knobs:\n"
+           "      --forwarding on|off    Data forwarding (default on)\n"
+           "      --predictor KIND       not-taken, 1bit (default) or 2bit\n"
+           "      --print-registers      Print the register file every cycle\n"
+           "      --print-pipeline       Print the pipeline registers every cycle\n"
+           "      --print-predictor      Print the BTB and PHT every cycle\n"
+           "      --trace-instruction N  Follow instruction N through the pipeline\n"
+           "\n"
+           "Cache model:\n"
+           "      --cache                Enable the cache timing model\n"
+           "      --l1i SIZE,WAYS,LINE,LATENCY\n"
+           "      --l1d SIZE,WAYS,LINE,LATENCY\n"
+           "      --l2 SIZE,WAYS,LINE,LATENCY\n"
+           "                             Geometry of one level; SIZE takes K/M suffixes\n"
+           "      --memory-latency N     Cycles to reach main memory (default 100)\n"
+           "      --replacement POLICY   lru (default), plru or random, for every level\n"
+           "      --write-through        Write-through instead of write-back\n"
+           "      --no-write-allocate    Do not allocate lines on write misses\n"
+           "\n"
+           "Tracing:\n"
+           "      --trace SPEC           Categories to trace, e.g. fetch,hazard:debug or all\n"
+           "      --trace-file FILE      Write the trace to FILE instead of stdout\n"
+           "\n"
+           "Batch runs:\n"
+           "      --batch FILE           Run the job list in FILE instead of one program\n"
+           "      --results FILE         Batch results, CSV or .json (default batch_results.csv)\n"
+           "      --threads N            Batch worker threads (default: all cores)\n"
+           "\n"
+           "  -h, --help                 Show this message\n";
+}
+
+// Decimal count with an optional K (1024) or M (1024 * 1024) suffix
+static bool parseCount(const string &text, uint64_t &value)
+{
+    if (text.empty() || !isdigit(static_cast<unsigned char>(text[0])))
+    {
+        return false;
+    }
+    char *end = nullptr;
+    value = strtoull(text.c_str(), &end, 10);
+    if (*end == 'K' || *end == 'k')
+    {
+        value *= 1024;
+        end++;
+    }
+    else if (*end == 'M' || *end == 'm')
+    {
+        value *= 1024 * 1024;
+        end++;
+    }
+    return *end == '\0';
+}
+
+static bool parseCount32(const string &text, uint32_t &value)
+{
+    uint64_t wide;
+    if (!parseCount(text, wide) || wide > UINT32_MAX)
+    {
+        return false;
+    }
+    value = static_cast<uint32_t>(wide);
+    return true;
+}
+
+// SIZE,WAYS,LINE,LATENCY; trailing fields may be left out
+static bool parseCacheLevel(const string &text, CacheConfig &config)
+{
+    uint32_t *fields[] = {&config.sizeBytes, &config.associativity, &config.lineSize, &config.latency};
+    stringstream parts(text);
+    string part;
+    size_t index = 0;
+    while (getline(parts, part, ','))
+    {
+        if (index == 4 || !parseCount32(part, *fields[index]))
+        {
+            return false;
+        }
+        index++;
+    }
+    return index > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    SimulationMode mode = SimulationMode::Pipelined;
+    uint64_t maxCycles = UINT64_MAX;
+    uint64_t maxInstructions = UINT64_MAX;
+    bool quiet = false;
+
+    CacheConfig l1i = cacheHierarchy.l1i.getConfig();
+    CacheConfig l1d = cacheHierarchy.l1d.getConfig();
+    CacheConfig l2 = cacheHierarchy.l2.getConfig();
+    uint32_t memoryLatency = cacheHierarchy.getMemoryLatency();
+
+    string traceSpec, traceFile, profileFile;
+    string batchFile, resultsFile = "batch_results.csv";
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        string value;
+        bool hasValue = false;
+
+        // Accept both "--name value" and "--name=value"
+        size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") == 0 && equals != string::npos)
+        {
+            value = arg.substr(equals + 1);
+            arg.resize(equals);
+            hasValue = true;
+        }
+
+        auto takeValue = [&]() -> bool
+        {
+            if (hasValue)
+            {
+                return true;
+            }
+            if (i + 1 >= argc)
+            {
+                cerr << "rvsim: " << arg << " needs a value" << endl;
+                return false;
+            }
+            value = argv[++i];
+            return true;
+        };
+        auto badValue = [&]()
+        {
+            cerr << "rvsim: invalid value '" << value << "' for " << arg << endl;
+            return 1;
+        };
+
+        if (arg == "-h" || arg == "--help")
+        {
+            printUsage(cout);
+            return 0;
+        }
+        else if (arg == "-q" || arg == "--quiet")
+            quiet = true;
+        else if (arg == "-m" || arg == "--mode")
+        {
+            if (!takeValue())
+                return 1;
+            if (!parseSimulationMode(value, mode))
+                return badValue();
+        }
+        else if (arg == "-i" || arg == "--input")
+        {
+            if (!takeValue())
+                return 1;
+            input_file = value;
+        }
+        else if (arg == "-o" || arg == "--output")
+        {
+            if (!takeValue())
+                return 1;
+            output_file = value;
+        }
+        else if (arg == "-s" || arg == "--stats")
+        {
+            if (!takeValue())
+                return 1;
+            stats_file = value;
+        }
+        else if (arg == "--max-cycles" || arg == "--max-insts")
+        {
+            if (!takeValue())
+                return 1;
+            if (!parseCount(value, arg == "--max-cycles" ? maxCycles : maxInstructions))
+                return badValue();
+        }
+        else if (arg == "--profile")
+        {
+            if (!takeValue())
+                return 1;
+            profileFile = value;
+        }
+        else if (arg == "--forwarding")
+        {
+            if (!takeValue())
+                return 1;
+            if (value == "on")
+                knob_data_forwarding = true;
+            else if (value == "off")
+                knob_data_forwarding = false;
+            else
+                return badValue();
+        }
+        else if (arg == "--predictor")
+        {
+            if (!takeValue())
+                return 1;
+            if (!parsePredictorKind(value, knob_branch_predictor))
+                return badValue();
+        }
+        else if (arg == "--print-registers")
+            knob_print_registers = true;
+        else if (arg == "--print-pipeline")
+            knob_print_pipeline_registers = true;
+        else if (arg == "--print-predictor")
+            knob_print_branch_predictor = true;
+        else if (arg == "--trace-instruction")
+        {
+            uint32_t number;
+            if (!takeValue())
+                return 1;
+            if (!parseCount32(value, number) || number > INT_MAX)
+                return badValue();
+            knob_trace_instruction = static_cast<int>(number);
+        }
+        else if (arg == "--cache")
+            knob_cache = true;
+        else if (arg == "--l1i" || arg == "--l1d" || arg == "--l2")
+        {
+            if (!takeValue())
+                return 1;
+            CacheConfig &level = (arg == "--l1i") ? l1i : (arg == "--l1d") ? l1d : l2;
+            if (!parseCacheLevel(value, level))
+                return badValue();
+        }
+        else if (arg == "--memory-latency")
+        {
+            if (!takeValue())
+                return 1;
+            if (!parseCount32(value, memoryLatency))
+                return badValue();
+        }
+        else if (arg == "--replacement")
+        {
+            ReplacementPolicy policy;
+            if (!takeValue())
+                return 1;
+            if (value == "lru")
+                policy = ReplacementPolicy::LRU;
+            else if (value == "plru")
+                policy = ReplacementPolicy::PLRU;
+            else if (value == "random")
+                policy = ReplacementPolicy::Random;
+            else
+                return badValue();
+            l1i.replacement = l1d.replacement = l2.replacement = policy;
+        }
+        else if (arg == "--write-through")
+            l1i.writeBack = l1d.writeBack = l2.writeBack = false;
+        else if (arg == "--no-write-allocate")
+            l1i.writeAllocate = l1d.writeAllocate = l2.writeAllocate = false;
+        else if (arg == "--trace")
+        {
+            if (!takeValue())
+                return 1;
+            traceSpec = value;
+        }
+        else if (arg == "--trace-file")
+        {
+            if (!takeValue())
+                return 1;
+            traceFile = value;
+        }
+        else if (arg == "--batch")
+        {
+            if (!takeValue())
+                return 1;
+            batchFile = value;
+        }
+        else if (arg == "--results")
+        {
+            if (!takeValue())
+                return 1;
+            resultsFile = value;
+        }
+        else if (arg == "--threads")
+        {
+            uint32_t count;
+            if (!takeValue())
+                return 1;
+            if (!parseCount32(value, count))
+                return badValue();
+            threads = count;
+        }
+        else if (arg[0] != '-' && !hasValue)
+            input_file = arg;
+        else
+        {
+            cerr << "rvsim: unknown option " << arg << " (see --help)" << endl;
+            return 1;
+        }
+    }
+
+    if (!cacheHierarchy.configure(l1i, l1d, l2, memoryLatency))
+    {
+        return 1;
+    }
+
+    if (!batchFile.empty())
+    {
+        return runBatchFile(batchFile, resultsFile, threads);
+    }
+
+    if (!profileFile.empty() && mode == SimulationMode::Fast)
+    {
+        cerr << "rvsim: --profile needs the pipelined or functional mode" << endl;
+        return 1;
+    }
+    knob_branch_profile = !profileFile.empty();
+
+    FILE *traceOutput = nullptr;
+    if (!traceFile.empty())
+    {
+        traceOutput = fopen(traceFile.c_str(), "w");
+        if (traceOutput == nullptr)
+        {
+            cerr << "rvsim: cannot open trace file " << traceFile << endl;
+            return 1;
+        }
+        traceSetOutput(traceOutput);
+    }
+    if (!traceSpec.empty() && !traceConfigure(traceSpec))
+    {
+        return 1;
+    }
+
+    // Setup the execution environment
+    knob_pipelining = (mode == SimulationMode::Pipelined);
+    resetSimulatorState();
+    initializeStack();
+    if (!loadMC(input_file))
+    {
+        return 1;
+    }
+    currentPC = entryPC;
+
+    // Loading traces through the buffer; keep its lines ahead of the console ones
+    traceFlush();
+    if (!quiet)
+    {
+        double seconds = max(lastLoad.seconds, 1e-9);
+        char rate[64];
+        snprintf(rate, sizeof(rate), "%.2f ms (%.1f MB/s)", seconds * 1e3, lastLoad.fileBytes / 1e6 / seconds);
+        cout << "Loaded " << input_file << ": " << lastLoad.fileBytes << " bytes in " << rate << endl;
+        if (!programSymbols.empty())
+        {
+            cout << "Entry point " << describeAddress(entryPC) << ", " << programSymbols.size() << " symbols" << endl;
+        }
+    }
+
+    // The functional models retire one instruction per cycle
+    bool limited = false;
+    switch (mode)
+    {
+    case SimulationMode::Pipelined:
+        runPipeline(maxCycles, maxInstructions);
+        limited = !exitSimulator;
+        break;
+    case SimulationMode::Functional:
+        runNonPipelined(min(maxCycles, maxInstructions));
+        limited = !exitSimulator && !infLoop && isValidPC(currentPC);
+        break;
+    case SimulationMode::Fast:
+        total_instructions = total_cycles = runFastFunctional(min(maxCycles, maxInstructions));
+        limited = !exitSimulator && !infLoop && isValidPC(currentPC);
+        break;
+    }
+
+    // Drain the trace before the final report
+    traceFlush();
+
+    // Quiet runs still write every file, but print only the statistics
+    streambuf *console = cout.rdbuf();
+    auto mute = [&](bool on)
+    {
+        if (quiet)
+        {
+            cout.rdbuf(on ? nullptr : console);
+            cout.clear();
+        }
+    };
+
+    mute(true);
+    if (mode != SimulationMode::Pipelined)
+    {
+        for (int i = 0; i < 32; i++)
+        {
+            cout << "R" << i << ": " << registerFile[i] << endl;
+        }
+    }
+    if (limited)
+    {
+        bool cycleLimit = static_cast<uint64_t>(total_cycles) >= maxCycles;
+        cout << "\nStopped at the " << (cycleLimit ? "cycle" : "instruction") << " limit in "
+             << describeAddress(currentPC) << "." << endl;
+    }
+    mute(false);
+
+    printStats();
+
+    mute(true);
+    saveStatsToFile(stats_file);
+    dumpMemoryToFile(output_file);
+    if (knob_branch_profile && !saveBranchProfile(profileFile))
+    {
+        mute(false);
+        return 1;
+    }
+    mute(false);
+
+    if (traceOutput != nullptr)
+    {
+        traceFlush();
+        traceSetOutput(stdout);
+        fclose(traceOutput);
+    }
+    return 0;
+}
@@ -1,19 +1,27 @@
-#ifndef NONPIPELINED_H
-#define NONPIPELINED_H
-
-#include "structs.h"
-#include <string>
-
-// Instruction pipeline stages
-void fetchInstruction();
-void decodeInstruction();
-void execute(Instruction instruction);
-void memoryAccess(Instruction instruction);
-void writeBack(Instruction instruction);
-void updatePC(Instruction instruction);
-
-// Memory and stack dumping functions
-void dumpMemoryToFile(const std::string &filename);
-void dumpStackToFile(const std::string &filename);
-
+#ifndef NONPIPELINED_H
+#define NONPIPELINED_H
+
+#include "structs.h"
+#include <string>
+#include <cstdint>
+
+// Run input_file one instruction at a time until it exits, then report
+void runNonPipelinedSimulation();
+
+// Run the already loaded program from currentPC until it exits or
+// maxInstructions have executed. Returns the instructions executed.
+uint64_t runNonPipelined(uint64_t maxInstructions = UINT64_MAX);
+
+// Instruction pipeline stages
+void fetchInstruction();
+void decodeInstruction();
+void execute(Instruction instruction);
+void memoryAccess(Instruction instruction);
+void writeBack(Instruction instruction);
+void updatePC(Instruction instruction);
+
+// Memory and stack dumping functions
+void dumpMemoryToFile(const std::string &filename);
+void dumpStackToFile(const std::string &filename);
+
 #endif // NONPIPELINED_H
\ No newline at end of file
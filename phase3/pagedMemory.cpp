@@ -0,0 +1,63 @@
+#include <bits/stdc++.h>
+#include "pagedMemory.h"
+
+using namespace std;
+
+uint8_t *PagedMemory::allocatePage(uint32_t address)
+{
+    unique_ptr<PageTable> &table = directory[address >> (PAGE_BITS + TABLE_BITS)];
+    if (!table)
+    {
+        table.reset(new PageTable());
+    }
+
+    unique_ptr<uint8_t[]> &page = table->pages[(address >> PAGE_BITS) & (TABLE_SIZE - 1)];
+    if (!page)
+    {
+        // Value-initialised, so new pages read as zero
+        page.reset(new uint8_t[PAGE_SIZE]());
+        pages++;
+    }
+    return page.get();
+}
+
+void PagedMemory::writeBytes(uint32_t address, const uint8_t *bytes, size_t length)
+{
+    while (length > 0)
+    {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        size_t span = min<size_t>(length, PAGE_SIZE - offset);
+        memcpy(touchPage(address) + offset, bytes, span);
+        address += span;
+        bytes += span;
+        length -= span;
+    }
+}
+
+void PagedMemory::fill(uint32_t address, uint8_t value, size_t length)
+{
+    while (length > 0)
+    {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        size_t span = min<size_t>(length, PAGE_SIZE - offset);
+        if (value != 0)
+        {
+            memset(touchPage(address) + offset, value, span);
+        }
+        else if (findPage(address) != nullptr)
+        {
+            memset(touchPage(address) + offset, 0, span);
+        }
+        address += span;
+        length -= span;
+    }
+}
+
+void PagedMemory::clear()
+{
+    for (uint32_t d = 0; d < TABLE_SIZE; d++)
+    {
+        directory[d].reset();
+    }
+    pages = 0;
+}
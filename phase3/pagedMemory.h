@@ -0,0 +1,153 @@
+// pagedMemory.h
+#ifndef PAGEDMEMORY_H
+#define PAGEDMEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "PagedMemory accessors assume a little-endian host"
+#endif
+
+// Sparse 32-bit guest address space. A two-level page table (10 + 10 bits)
+// maps 4 KiB pages that are allocated on first write. Unmapped memory
+// reads as zero without allocating anything.
+class PagedMemory
+{
+public:
+    static constexpr uint32_t PAGE_BITS = 12;
+    static constexpr uint32_t PAGE_SIZE = 1u << PAGE_BITS;
+    static constexpr uint32_t TABLE_BITS = 10;
+    static constexpr uint32_t TABLE_SIZE = 1u << TABLE_BITS;
+
+    PagedMemory() = default;
+    PagedMemory(const PagedMemory &) = delete;
+    PagedMemory &operator=(const PagedMemory &) = delete;
+
+    // Little-endian accessors
+    uint8_t read8(uint32_t address) const { return read<uint8_t>(address); }
+    uint16_t read16(uint32_t address) const { return read<uint16_t>(address); }
+    uint32_t read32(uint32_t address) const { return read<uint32_t>(address); }
+    uint64_t read64(uint32_t address) const { return read<uint64_t>(address); }
+
+    void write8(uint32_t address, uint8_t value) { write<uint8_t>(address, value); }
+    void write16(uint32_t address, uint16_t value) { write<uint16_t>(address, value); }
+    void write32(uint32_t address, uint32_t value) { write<uint32_t>(address, value); }
+    void write64(uint32_t address, uint64_t value) { write<uint64_t>(address, value); }
+
+    // Page holding address, or nullptr if it was never written
+    const uint8_t *findPage(uint32_t address) const
+    {
+        const PageTable *table = directory[address >> (PAGE_BITS + TABLE_BITS)].get();
+        if (table == nullptr)
+        {
+            return nullptr;
+        }
+        return table->pages[(address >> PAGE_BITS) & (TABLE_SIZE - 1)].get();
+    }
+
+    // Page holding address, allocated and zero-filled if needed
+    uint8_t *touchPage(uint32_t address)
+    {
+        PageTable *table = directory[address >> (PAGE_BITS + TABLE_BITS)].get();
+        if (table != nullptr)
+        {
+            uint8_t *page = table->pages[(address >> PAGE_BITS) & (TABLE_SIZE - 1)].get();
+            if (page != nullptr)
+            {
+                return page;
+            }
+        }
+        return allocatePage(address);
+    }
+
+    // Copy length bytes in, allocating pages as needed
+    void writeBytes(uint32_t address, const uint8_t *bytes, size_t length);
+
+    // Set length bytes to value. Zero fills skip unmapped pages, which
+    // already read as zero.
+    void fill(uint32_t address, uint8_t value, size_t length);
+
+    // Drop every page
+    void clear();
+
+    // Number of allocated pages
+    size_t pageCount() const { return pages; }
+
+    // Visit allocated pages in ascending address order
+    template <typename Visitor>
+    void forEachPage(Visitor visit) const
+    {
+        for (uint32_t d = 0; d < TABLE_SIZE; d++)
+        {
+            const PageTable *table = directory[d].get();
+            if (table == nullptr)
+            {
+                continue;
+            }
+            for (uint32_t p = 0; p < TABLE_SIZE; p++)
+            {
+                const uint8_t *page = table->pages[p].get();
+                if (page != nullptr)
+                {
+                    visit((d << (PAGE_BITS + TABLE_BITS)) | (p << PAGE_BITS), page);
+                }
+            }
+        }
+    }
+
+private:
+    struct PageTable
+    {
+        std::unique_ptr<uint8_t[]> pages[TABLE_SIZE];
+    };
+
+    std::unique_ptr<PageTable> directory[TABLE_SIZE];
+    size_t pages = 0;
+
+    uint8_t *allocatePage(uint32_t address);
+
+    template <typename T>
+    T read(uint32_t address) const
+    {
+        T value = 0;
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        if (offset + sizeof(T) <= PAGE_SIZE)
+        {
+            const uint8_t *page = findPage(address);
+            if (page != nullptr)
+            {
+                std::memcpy(&value, page + offset, sizeof(T));
+            }
+            return value;
+        }
+
+        // Access straddles two pages
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            value |= static_cast<T>(read<uint8_t>(address + i)) << (8 * i);
+        }
+        return value;
+    }
+
+    template <typename T>
+    void write(uint32_t address, T value)
+    {
+        uint32_t offset = address & (PAGE_SIZE - 1);
+        if (offset + sizeof(T) <= PAGE_SIZE)
+        {
+            std::memcpy(touchPage(address) + offset, &value, sizeof(T));
+            return;
+        }
+
+        // Access straddles two pages
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            write<uint8_t>(address + i, static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+};
+
+#endif // PAGEDMEMORY_H
@@ -1,24 +1,30 @@
-#ifndef PIPELINED_H
-#define PIPELINED_H
-
-#include <string>
-#include <map>
-#include "structs.h"
-
-// Main simulation function
-void runPipelinedSimulation();
-
-// Pipeline stage functions
-void pipelineIF();
-void pipelineID();
-void pipelineEX();
-void pipelineMEM();
-void pipelineWB();
-
-// Debug and visualization functions
-void printPipelineRegisters();
-void printBranchPredictorState();
-void traceSpecificInstruction(int instructionNumber);
-
-
-#endif // PIPELINED_H
+#ifndef PIPELINED_H
+#define PIPELINED_H
+
+#include <string>
+#include <map>
+#include <cstdint>
+#include "structs.h"
+
+// Main simulation function: load input_file, run it and report
+void runPipelinedSimulation();
+
+// Clock the already loaded program through the pipeline until it exits,
+// maxCycles have elapsed or maxInstructions have retired. Returns the
+// cycles simulated; prints nothing unless tracing or a debug knob is on.
+uint64_t runPipeline(uint64_t maxCycles = UINT64_MAX, uint64_t maxInstructions = UINT64_MAX);
+
+// Pipeline stage functions
+void pipelineIF();
+void pipelineID();
+void pipelineEX();
+void pipelineMEM();
+void pipelineWB();
+
+// Debug and visualization functions
+void printPipelineRegisters();
+void printBranchPredictorState();
+void traceSpecificInstruction(int instructionNumber);
+
+
+#endif // PIPELINED_H
@@ -1,11 +1,20 @@
-#ifndef STATS_H
-#define STATS_H
-
-// Performance monitoring and statistics reporting functions
-void initializeStats();      // Reset all performance counters
-void updateStats();          // Track instruction execution metrics
-void printStats();           // Display current statistics to console
-void saveStatsToFile(const std::string &filename);  // Export statistics to a file
-void printRegisterFile();    // Display contents of all registers
-
-#endif // STATS_H
+#ifndef STATS_H
+#define STATS_H
+
+#include <string>
+#include <cstdint>
+#include "structs.h"
+
+// Performance monitoring and statistics reporting functions
+void initializeStats();      // Reset all performance counters
+void updateStats(const Instruction &retired); // Count an instruction retiring from WB
+void printStats();           // Display current statistics to console
+void saveStatsToFile(const std::string &filename);  // Export statistics to a file
+void printRegisterFile();    // Display contents of all registers
+
+// Count one outcome of the conditional branch at pc (with knob_branch_profile)
+void recordBranchOutcome(uint32_t pc, bool taken);
+// Write "pc taken not-taken" per branch, sorted by pc; false if the file cannot be written
+bool saveBranchProfile(const std::string &filename);
+
+#endif // STATS_H
@@ -1,51 +1,217 @@
-#include "structs.h"
-
-// Branch prediction implementation
-
-bool BranchPredictor::predict(const std::string &pc)
-{
-    // Keep track of total branch predictions requested
-    predictions++;
-
-    // Check branch history to see if we've encountered this address before
-    if (pht.find(pc) != pht.end())
-    {
-        // Use historical data to make prediction
-        return pht[pc];
-    }
-    
-    // For new branch addresses, default to not taken (conservative approach)
-    return false;
-}
-
-std::string BranchPredictor::getTarget(const std::string &pc)
-{
-    // Look up target address in branch target buffer
-    if (btb.find(pc) != btb.end())
-    {
-        // Found a previously recorded target address
-        return btb[pc];
-    }
-    
-    // No target information available for this branch
-    return "";
-}
-
-void BranchPredictor::update(const std::string &pc, bool taken, const std::string &target)
-{
-    // Evaluate prediction accuracy
-    if (pht.find(pc) != pht.end() && pht[pc] == taken)
-    {
-        // Record successful prediction
-        correct_predictions++;
-    }
-
-    // Update our prediction model with actual outcome
-    pht[pc] = taken;
-
-    // Only store target addresses for taken branches
-    if (taken)
-    {
-        btb[pc] = target;
-    }
-}
+#include "structs.h"
+
+// Enum naming helpers
+
+const char *typeName(InstType type)
+{
+    switch (type)
+    {
+    case InstType::None: return "";
+    case InstType::R: return "R-Type";
+    case InstType::I: return "I-Type";
+    case InstType::Load: return "Load_I-Type";
+    case InstType::S: return "S-Type";
+    case InstType::SB: return "SB-Type";
+    case InstType::LUI: return "LUI_U-Type";
+    case InstType::AUIPC: return "AUIPC_U-Type";
+    case InstType::JAL: return "JAL_J-Type";
+    case InstType::JALR: return "JALR_I-Type";
+    case InstType::Unknown: return "Unknown";
+    }
+    return "Unknown";
+}
+
+const char *mnemonicName(Mnemonic name)
+{
+    static const char *const names[] = {
+        "NOP",
+        "ADD", "SUB", "MUL", "DIV", "REM", "AND", "OR", "XOR", "SLL", "SRL", "SRA", "SLT",
+        "SLTU", "MULH", "MULHSU", "MULHU", "DIVU", "REMU",
+        "ADDI", "ANDI", "ORI", "XORI", "SLTI", "SLTIU", "SLLI", "SRLI", "SRAI",
+        "LB", "LH", "LW", "LD", "LBU", "LHU",
+        "SB", "SH", "SW", "SD",
+        "BEQ", "BNE", "BLT", "BGE", "BLTU", "BGEU",
+        "LUI", "AUIPC", "JAL", "JALR",
+        "FENCE", "ECALL", "EBREAK",
+        "Unknown"};
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Mnemonic::UNKNOWN) + 1, "one name per mnemonic");
+    return names[static_cast<int>(name)];
+}
+
+std::ostream &operator<<(std::ostream &os, InstType type)
+{
+    return os << typeName(type);
+}
+
+std::ostream &operator<<(std::ostream &os, Mnemonic name)
+{
+    return os << mnemonicName(name);
+}
+
+Instruction decodeWord(uint32_t word)
+{
+    Instruction inst;
+    inst.opcode = word & 0x7F;
+    inst.fun3 = (word >> 12) & 0x7;
+    inst.fun7 = (word >> 25) & 0x7F;
+
+    const IsaEntry *entry = isaDecode(word);
+    if (entry == nullptr)
+    {
+        inst.type = InstType::Unknown;
+        inst.name = Mnemonic::UNKNOWN;
+        return inst;
+    }
+
+    inst.type = entry->type;
+    inst.name = entry->id;
+    inst.iclass = entry->iclass;
+
+    // Only fill the register fields the format actually has
+    if (layoutWritesRd(entry->layout))
+    {
+        inst.rd = rdField(word);
+    }
+    if (layoutReadsRs1(entry->layout))
+    {
+        inst.rs1 = rs1Field(word);
+    }
+    if (layoutReadsRs2(entry->layout))
+    {
+        inst.rs2 = rs2Field(word);
+    }
+    inst.imm = isaImmediate(entry->type, word);
+    if (isaShiftImmediate(*entry))
+    {
+        // funct7 shares the immediate; only the low 5 bits are the shamt
+        inst.imm &= 0x1F;
+    }
+    return inst;
+}
+
+bool isExitInstruction(const Instruction &inst)
+{
+    return (inst.name == Mnemonic::ADDI && inst.rs1 == 0 && inst.rd == 0 && inst.imm == 1) ||
+           inst.name == Mnemonic::ECALL || inst.name == Mnemonic::EBREAK;
+}
+
+const char *predictorName(PredictorKind kind)
+{
+    switch (kind)
+    {
+    case PredictorKind::NotTaken:
+        return "not-taken";
+    case PredictorKind::TwoBit:
+        return "2bit";
+    default:
+        return "1bit";
+    }
+}
+
+bool parsePredictorKind(const std::string &name, PredictorKind &kind)
+{
+    if (name == "not-taken")
+        kind = PredictorKind::NotTaken;
+    else if (name == "1bit")
+        kind = PredictorKind::OneBit;
+    else if (name == "2bit")
+        kind = PredictorKind::TwoBit;
+    else
+        return false;
+    return true;
+}
+
+// Branch prediction implementation
+
+bool BranchPredictor::predict(uint32_t pc)
+{
+    // Keep track of total branch predictions requested
+    predictions++;
+
+    if (kind == PredictorKind::NotTaken)
+    {
+        return false;
+    }
+    if (kind == PredictorKind::TwoBit)
+    {
+        // New branches start weakly not taken
+        auto counter = counters.find(pc);
+        return counter != counters.end() && counter->second >= 2;
+    }
+
+    // Check branch history to see if we've encountered this address before
+    auto it = pht.find(pc);
+    if (it != pht.end())
+    {
+        // Use historical data to make prediction
+        return it->second;
+    }
+    
+    // For new branch addresses, default to not taken (conservative approach)
+    return false;
+}
+
+bool BranchPredictor::getTarget(uint32_t pc, uint32_t &target)
+{
+    // Look up target address in branch target buffer
+    auto it = btb.find(pc);
+    if (it != btb.end())
+    {
+        // Found a previously recorded target address
+        target = it->second;
+        return true;
+    }
+    
+    // No target information available for this branch
+    return false;
+}
+
+void BranchPredictor::update(uint32_t pc, bool taken, uint32_t target)
+{
+    if (kind != PredictorKind::OneBit)
+    {
+        bool predictedTaken = false;
+        if (kind == PredictorKind::TwoBit)
+        {
+            // Saturating counter: 0-1 predict not taken, 2-3 predict taken
+            uint8_t &counter = counters.try_emplace(pc, 1).first->second;
+            predictedTaken = counter >= 2;
+            if (taken && counter < 3)
+                counter++;
+            else if (!taken && counter > 0)
+                counter--;
+            pht[pc] = counter >= 2;
+        }
+        else
+        {
+            pht[pc] = false;
+        }
+
+        if (predictedTaken == taken)
+        {
+            correct_predictions++;
+        }
+        if (taken)
+        {
+            btb[pc] = target;
+        }
+        return;
+    }
+
+    // Evaluate prediction accuracy
+    auto it = pht.find(pc);
+    if (it != pht.end() && it->second == taken)
+    {
+        // Record successful prediction
+        correct_predictions++;
+    }
+
+    // Update our prediction model with actual outcome
+    pht[pc] = taken;
+
+    // Only store target addresses for taken branches
+    if (taken)
+    {
+        btb[pc] = target;
+    }
+}
@@ -1,82 +1,132 @@
-// structs.h
-#ifndef STRUCTS_H
-#define STRUCTS_H
-
-#include <string>
-#include <unordered_map>
-
-// Decoded instruction representation
-struct Instruction
-{
-    std::string type;        // Instruction format type (R-type, I-type, etc.)
-    std::string name;        // Mnemonic representation
-    int opcode;              // Primary operation code
-    int rs1;                 // First source register
-    int rs2;                 // Second source register
-    int rd;                  // Destination register
-    int fun3;                // Function code 3
-    int fun7;                // Function code 7
-    long long int imm;       // Immediate value
-};
-
-// Fetch-Decode pipeline register
-struct IF_ID_Register
-{
-    std::string instruction; // Raw instruction bits
-    std::string pc;          // Program counter value
-};
-
-// Decode-Execute pipeline register
-struct ID_EX_Register
-{
-    std::string pc;          // Program counter value
-    Instruction decodedInst; // Decoded instruction data
-    int rs1_value;           // Value read from first source register
-    int rs2_value;           // Value read from second source register
-    bool isStall;            // Indicates if this stage is stalled
-};
-
-// Execute-Memory pipeline register
-struct EX_MEM_Register
-{
-    std::string pc;              // Program counter value
-    Instruction decodedInst;     // Decoded instruction data
-    long long int aluResult;     // Result from ALU operation
-    int rs2_value;               // Value from second source register (for stores)
-    std::string branchTarget;    // Target address for branch instructions
-    bool branchTaken;            // Whether branch condition was true
-    unsigned int returnAddress;  // Return address for jumps
-};
-
-// Memory-Writeback pipeline register
-struct MEM_WB_Register
-{
-    std::string pc;              // Program counter value
-    Instruction decodedInst;     // Decoded instruction data
-    long long int aluResult;     // Result from ALU operation
-    int memoryData;              // Data loaded from memory
-    long long int writebackData; // Final data to write back to register
-};
-
-// Branch prediction unit
-struct BranchPredictor
-{
-    std::unordered_map<std::string, bool> pht;        // Pattern History Table - tracks taken/not taken
-    std::unordered_map<std::string, std::string> btb; // Branch Target Buffer - stores target addresses
-    int predictions;                                  // Count of total predictions made
-    int correct_predictions;                          // Count of accurate predictions
-
-    // Initialize with zero predictions
-    BranchPredictor() : predictions(0), correct_predictions(0) {}
-
-    // Predict whether a branch at given PC will be taken
-    bool predict(const std::string &pc);
-    
-    // Get predicted target address for a branch
-    std::string getTarget(const std::string &pc);
-    
-    // Update prediction tables with actual branch outcome
-    void update(const std::string &pc, bool taken, const std::string &target);
-};
-
-#endif // STRUCTS_H
+// structs.h
+#ifndef STRUCTS_H
+#define STRUCTS_H
+
+#include <string>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <unordered_map>
+#include "isa.h"
+
+// Decoded instruction representation
+struct Instruction
+{
+    InstType type = InstType::None;    // Instruction format type (R-type, I-type, etc.)
+    Mnemonic name = Mnemonic::NOP;     // Mnemonic ID
+    InstClass iclass = InstClass::None; // Functional class
+    int opcode = 0;                    // Primary operation code
+    int rs1 = 0;                       // First source register
+    int rs2 = 0;                       // Second source register
+    int rd = 0;                        // Destination register
+    int fun3 = 0;                      // Function code 3
+    int fun7 = 0;                      // Function code 7
+    long long int imm = 0;             // Immediate value
+};
+
+// Printable names for the enums above
+const char *typeName(InstType type);
+const char *mnemonicName(Mnemonic name);
+std::ostream &operator<<(std::ostream &os, InstType type);
+std::ostream &operator<<(std::ostream &os, Mnemonic name);
+
+// Decode a raw instruction word through the shared ISA table
+Instruction decodeWord(uint32_t word);
+
+// addi x0, x0, 1, ecall and ebreak end the program
+bool isExitInstruction(const Instruction &inst);
+
+// Fetch-Decode pipeline register
+struct IF_ID_Register
+{
+    uint32_t instruction = 0; // Raw instruction word (0 when empty)
+    uint32_t pc = 0;          // Program counter value
+    bool predictedTaken = false; // IF fetched the branch target next
+};
+
+// Decode-Execute pipeline register
+struct ID_EX_Register
+{
+    uint32_t pc = 0;         // Program counter value
+    Instruction decodedInst; // Decoded instruction data
+    int rs1_value = 0;       // Value read from first source register
+    int rs2_value = 0;       // Value read from second source register
+    bool isStall = false;    // Indicates if this stage is stalled
+    bool predictedTaken = false; // IF fetched the branch target next
+};
+
+// Execute-Memory pipeline register
+struct EX_MEM_Register
+{
+    uint32_t pc = 0;             // Program counter value
+    Instruction decodedInst;     // Decoded instruction data
+    long long int aluResult = 0; // Result from ALU operation
+    int rs2_value = 0;           // Value from second source register (for stores)
+    uint32_t branchTarget = 0;   // Target address for branch instructions
+    bool branchTaken = false;    // Whether branch condition was true
+    unsigned int returnAddress = 0; // Return address for jumps
+    bool predictedTaken = false;    // IF fetched the branch target next
+};
+
+// Memory-Writeback pipeline register
+struct MEM_WB_Register
+{
+    uint32_t pc = 0;             // Program counter value
+    Instruction decodedInst;     // Decoded instruction data
+    long long int aluResult = 0; // Result from ALU operation
+    int memoryData = 0;          // Data loaded from memory
+    long long int writebackData = 0; // Final data to write back to register
+};
+
+// Pipeline registers are copied every cycle and must stay plain data
+static_assert(std::is_trivially_copyable<Instruction>::value, "Instruction must be trivially copyable");
+static_assert(std::is_trivially_copyable<IF_ID_Register>::value, "IF_ID_Register must be trivially copyable");
+static_assert(std::is_trivially_copyable<ID_EX_Register>::value, "ID_EX_Register must be trivially copyable");
+static_assert(std::is_trivially_copyable<EX_MEM_Register>::value, "EX_MEM_Register must be trivially copyable");
+static_assert(std::is_trivially_copyable<MEM_WB_Register>::value, "MEM_WB_Register must be trivially copyable");
+
+// Direction prediction scheme
+enum class PredictorKind
+{
+    NotTaken, // Static: always predict fall-through
+    OneBit,   // Last outcome per branch
+    TwoBit    // Saturating two-bit counter per branch
+};
+
+// Printable name ("not-taken", "1bit", "2bit") and its inverse.
+// parsePredictorKind returns false for an unknown name.
+const char *predictorName(PredictorKind kind);
+bool parsePredictorKind(const std::string &name, PredictorKind &kind);
+
+// Outcomes of one conditional branch, collected for --profile
+struct BranchCounts
+{
+    uint64_t taken = 0;
+    uint64_t notTaken = 0;
+};
+
+// Branch prediction unit
+struct BranchPredictor
+{
+    std::unordered_map<uint32_t, bool> pht;     // Pattern History Table - tracks taken/not taken
+    std::unordered_map<uint32_t, uint32_t> btb; // Branch Target Buffer - stores target addresses
+    std::unordered_map<uint32_t, uint8_t> counters; // Two-bit counters (TwoBit only)
+    PredictorKind kind;                               // Direction prediction scheme
+    int predictions;                                  // Count of total predictions made
+    int correct_predictions;                          // Count of accurate predictions
+
+    // Initialize with zero predictions
+    explicit BranchPredictor(PredictorKind kind = PredictorKind::OneBit)
+        : kind(kind), predictions(0), correct_predictions(0) {}
+
+    // Predict whether a branch at given PC will be taken
+    bool predict(uint32_t pc);
+    
+    // Get predicted target address for a branch; false if none is recorded
+    bool getTarget(uint32_t pc, uint32_t &target);
+    
+    // Update prediction tables with actual branch outcome
+    void update(uint32_t pc, bool taken, uint32_t target);
+};
+
+#endif // STRUCTS_H
@@ -0,0 +1,144 @@
+// Steady-state allocation check for the pipelined model.
+//
+// Replaces the global operator new with a counting one, warms the pipeline
+// up on a loop (first-touch memory pages, predictor entries, cache sets and
+// the branch profile may allocate) and then requires that a further run of
+// cycles allocates nothing, for every forwarding/predictor/cache setting.
+// Exits non-zero on the first configuration that allocates.
+
+#include <bits/stdc++.h>
+#include "globals.h"
+#include "stack.h"
+#include "utils.h"
+#include "pipelined.h"
+
+using namespace std;
+
+static atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// Loads, stores, M-extension ops, a call and a data-dependent branch;
+// x6 counts down from 2^31, so the loop outlives any run below
+static const char program[] =
+    ".data\n"
+    "buf: .word 1, 2, 3, 4\n"
+    ".text\n"
+    "main:\n"
+    "    lui x5, 0x10000\n"
+    "    lui x6, 0x80000\n"
+    "loop:\n"
+    "    lw x7, 0(x5)\n"
+    "    addi x7, x7, 3\n"
+    "    mul x8, x7, x7\n"
+    "    div x9, x8, x7\n"
+    "    sw x9, 4(x5)\n"
+    "    addi x2, x2, -4\n"
+    "    sw x7, 0(x2)\n"
+    "    jal x1, leaf\n"
+    "    lw x7, 0(x2)\n"
+    "    addi x2, x2, 4\n"
+    "    andi x10, x6, 1\n"
+    "    beq x10, x0, even\n"
+    "    xori x11, x11, 1\n"
+    "even:\n"
+    "    addi x6, x6, -1\n"
+    "    bne x6, x0, loop\n"
+    "    ecall\n"
+    "leaf:\n"
+    "    slli x12, x7, 2\n"
+    "    jalr x0, x1, 0\n";
+
+static const uint64_t WARMUP_CYCLES = 10000;
+static const uint64_t MEASURED_CYCLES = 200000;
+
+int main()
+{
+    string source = (filesystem::temp_directory_path() / "rvsim_allocations.asm").string();
+    {
+        ofstream out(source);
+        out << program;
+        if (!out)
+        {
+            cerr << "cannot write " << source << endl;
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    for (bool forwarding : {true, false})
+    {
+        for (PredictorKind predictor : {PredictorKind::NotTaken, PredictorKind::OneBit, PredictorKind::TwoBit})
+        {
+            for (bool cache : {false, true})
+            {
+                knob_data_forwarding = forwarding;
+                knob_branch_predictor = predictor;
+                knob_cache = cache;
+
+                resetSimulatorState();
+                initializeStack();
+                if (!loadMC(source))
+                {
+                    return 1;
+                }
+                currentPC = entryPC;
+
+                runPipeline(WARMUP_CYCLES);
+                size_t before = allocations.load(memory_order_relaxed);
+                uint64_t cycles = runPipeline(MEASURED_CYCLES);
+                size_t allocated = allocations.load(memory_order_relaxed) - before;
+
+                printf("forwarding=%s predictor=%s cache=%s: %zu allocations in %llu cycles\n",
+                       forwarding ? "on" : "off", predictorName(predictor), cache ? "on" : "off",
+                       allocated, static_cast<unsigned long long>(cycles));
+                if (allocated != 0 || cycles != MEASURED_CYCLES)
+                {
+                    failures++;
+                }
+            }
+        }
+    }
+
+    remove(source.c_str());
+    if (failures != 0)
+    {
+        printf("FAILED: %d configuration(s) allocated or stopped early\n", failures);
+        return 1;
+    }
+    printf("OK: no allocations in steady state\n");
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Entry point check for programs whose main is not their first line.
+//
+// Runs the same source as a .asm file and as the output.mc the assembler
+// writes for it, in the functional and the pipelined model, and requires
+// every run to start at main: the helper in front of it must only run
+// when main calls it. Exits non-zero if any run differs.
+
+#include <bits/stdc++.h>
+#include "globals.h"
+#include "stack.h"
+#include "utils.h"
+#include "nonPipelined.h"
+#include "pipelined.h"
+#include "assembler.h"
+
+using namespace std;
+
+// Falling into helper from address 0 returns to x1 = 0 and loops forever
+static const char program[] =
+    "helper:\n"
+    "    addi x5, x5, 7\n"
+    "    jalr x0, x1, 0\n"
+    "main:\n"
+    "    addi x6, x0, 3\n"
+    "    jal x1, helper\n"
+    "    addi x0, x0, 1\n";
+
+// Far more than the program needs; reaching it means the run never exited
+static const uint64_t LIMIT = 1000;
+
+// Load path and run it in one model; false if it did not exit with
+// x5 = 7 and x6 = 3
+static bool run(const string &path, bool pipelined)
+{
+    resetSimulatorState();
+    initializeStack();
+    if (!loadMC(path))
+    {
+        return false;
+    }
+    currentPC = entryPC;
+    uint64_t used = pipelined ? runPipeline(LIMIT) : runNonPipelined(LIMIT);
+
+    printf("%s %s: x5=%d x6=%d%s\n", path.c_str(), pipelined ? "pipelined" : "functional",
+           registerFile[5], registerFile[6], used < LIMIT ? "" : " (did not exit)");
+    return used < LIMIT && registerFile[5] == 7 && registerFile[6] == 3;
+}
+
+int main()
+{
+    filesystem::path directory = filesystem::temp_directory_path();
+    string source = (directory / "rvsim_entry.asm").string();
+    string listing = (directory / "rvsim_entry.mc").string();
+
+    AssemblerOptions options;
+    options.listing = true;
+    ProgramImage image = assemble(program, options);
+    {
+        ofstream asmOut(source);
+        asmOut << program;
+        ofstream mcOut(listing);
+        for (const string &piece : image.listing)
+        {
+            mcOut << piece;
+        }
+        if (!image.ok() || !asmOut || !mcOut)
+        {
+            cerr << image.errors << "cannot write " << source << " and " << listing << endl;
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    for (const string &path : {source, listing})
+    {
+        for (bool pipelined : {false, true})
+        {
+            if (!run(path, pipelined))
+            {
+                failures++;
+            }
+        }
+    }
+
+    remove(source.c_str());
+    remove(listing.c_str());
+    if (failures != 0)
+    {
+        printf("FAILED: %d run(s) did not start at main\n", failures);
+        return 1;
+    }
+    printf("OK: every run started at main\n");
+    return 0;
+}
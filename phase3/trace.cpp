@@ -0,0 +1,323 @@
+#include <bits/stdc++.h>
+#include "trace.h"
+
+using namespace std;
+
+uint8_t traceLevels[static_cast<size_t>(TraceCategory::Count)] = {};
+
+const char TRACE_SEPARATOR[] =
+    "====================================================================================================================================\n";
+
+// Single-producer single-consumer ring of pending records
+static constexpr uint64_t RING_SIZE = 1 << 14;
+static constexpr uint64_t RING_MASK = RING_SIZE - 1;
+
+// Records formatted per batch before the consumer releases their slots
+static constexpr uint64_t BATCH_SIZE = 1024;
+
+// Formatted bytes buffered before they are written out
+static constexpr size_t WRITE_THRESHOLD = 1 << 16;
+
+static TraceRecord ring[RING_SIZE];
+alignas(64) static atomic<uint64_t> head{0};    // Next slot the producer fills
+alignas(64) static atomic<uint64_t> tail{0};    // Next slot the consumer formats
+alignas(64) static atomic<uint64_t> written{0}; // Records written and flushed
+
+static FILE *output = stdout;
+
+// Owns the formatter thread; the destructor drains the ring at exit
+struct TraceFormatter
+{
+    thread worker;
+    atomic<bool> stopping{false};
+    bool running = false;
+
+    ~TraceFormatter()
+    {
+        if (running)
+        {
+            stopping.store(true, memory_order_release);
+            worker.join();
+        }
+    }
+};
+
+static TraceFormatter formatter;
+
+// Append one record to out, printf style
+static void formatRecord(const TraceRecord &record, string &out)
+{
+    const char *p = record.format;
+    uint32_t arg = 0;
+
+    while (*p != '\0')
+    {
+        if (*p != '%')
+        {
+            const char *next = strchr(p, '%');
+            size_t length = (next != nullptr) ? static_cast<size_t>(next - p) : strlen(p);
+            out.append(p, length);
+            p += length;
+            continue;
+        }
+
+        p++;
+        if (*p == '%')
+        {
+            out += '%';
+            p++;
+            continue;
+        }
+
+        // Flags, width and length modifier
+        bool zeroPad = false;
+        if (*p == '0')
+        {
+            zeroPad = true;
+            p++;
+        }
+        size_t width = 0;
+        while (*p >= '0' && *p <= '9')
+        {
+            width = width * 10 + (*p - '0');
+            p++;
+        }
+        bool wide = false;
+        while (*p == 'l')
+        {
+            wide = true;
+            p++;
+        }
+        char conversion = *p;
+        if (conversion == '\0')
+        {
+            break;
+        }
+        p++;
+
+        uint64_t value = (arg < record.argCount) ? record.args[arg++] : 0;
+        char buffer[32];
+        const char *text = buffer;
+        int length = 0;
+
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            length = snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+            break;
+        case 'u':
+            length = snprintf(buffer, sizeof(buffer), "%llu",
+                              static_cast<unsigned long long>(wide ? value : static_cast<uint32_t>(value)));
+            break;
+        case 'x':
+            length = snprintf(buffer, sizeof(buffer), "%llx",
+                              static_cast<unsigned long long>(wide ? value : static_cast<uint32_t>(value)));
+            break;
+        case 'X':
+            length = snprintf(buffer, sizeof(buffer), "%llX",
+                              static_cast<unsigned long long>(wide ? value : static_cast<uint32_t>(value)));
+            break;
+        case 'c':
+            buffer[0] = static_cast<char>(value);
+            length = 1;
+            break;
+        case 's':
+            text = reinterpret_cast<const char *>(static_cast<uintptr_t>(value));
+            if (text == nullptr)
+            {
+                text = "(null)";
+            }
+            length = static_cast<int>(strlen(text));
+            zeroPad = false;
+            break;
+        default:
+            // Unknown conversion: print it verbatim
+            buffer[0] = '%';
+            buffer[1] = conversion;
+            length = 2;
+            break;
+        }
+
+        if (static_cast<size_t>(length) < width)
+        {
+            out.append(width - length, zeroPad ? '0' : ' ');
+        }
+        out.append(text, length);
+    }
+}
+
+static void formatterLoop()
+{
+    string buffer;
+    buffer.reserve(2 * WRITE_THRESHOLD);
+    uint64_t position = tail.load(memory_order_relaxed);
+
+    while (true)
+    {
+        // Read the stop flag first so records committed before it are drained
+        bool stop = formatter.stopping.load(memory_order_acquire);
+        uint64_t available = head.load(memory_order_acquire);
+
+        if (position != available)
+        {
+            uint64_t end = min(available, position + BATCH_SIZE);
+            for (; position < end; position++)
+            {
+                formatRecord(ring[position & RING_MASK], buffer);
+            }
+            tail.store(position, memory_order_release);
+
+            if (buffer.size() >= WRITE_THRESHOLD)
+            {
+                fwrite(buffer.data(), 1, buffer.size(), output);
+                buffer.clear();
+            }
+            continue;
+        }
+
+        // Caught up: push everything out before going idle
+        if (!buffer.empty())
+        {
+            fwrite(buffer.data(), 1, buffer.size(), output);
+            buffer.clear();
+        }
+        if (written.load(memory_order_relaxed) != position)
+        {
+            fflush(output);
+            written.store(position, memory_order_release);
+        }
+
+        if (stop)
+        {
+            break;
+        }
+        this_thread::sleep_for(chrono::microseconds(50));
+    }
+}
+
+TraceRecord &traceReserve()
+{
+    if (!formatter.running)
+    {
+        // Console output written so far must precede the trace
+        fflush(stdout);
+        formatter.running = true;
+        formatter.worker = thread(formatterLoop);
+    }
+
+    // Wait for the formatter when the ring is full; records are never dropped
+    uint64_t slot = head.load(memory_order_relaxed);
+    while (slot - tail.load(memory_order_acquire) >= RING_SIZE)
+    {
+        this_thread::yield();
+    }
+    return ring[slot & RING_MASK];
+}
+
+void traceCommit()
+{
+    head.store(head.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+void traceFlush()
+{
+    if (!formatter.running)
+    {
+        return;
+    }
+    uint64_t target = head.load(memory_order_relaxed);
+    while (written.load(memory_order_acquire) != target)
+    {
+        this_thread::yield();
+    }
+}
+
+void traceSetOutput(FILE *out)
+{
+    traceFlush();
+    output = out;
+}
+
+void traceSetLevel(TraceCategory category, TraceLevel level)
+{
+    traceLevels[static_cast<size_t>(category)] = static_cast<uint8_t>(level);
+}
+
+void traceSetAllLevels(TraceLevel level)
+{
+    for (size_t i = 0; i < static_cast<size_t>(TraceCategory::Count); i++)
+    {
+        traceLevels[i] = static_cast<uint8_t>(level);
+    }
+}
+
+bool traceConfigure(const string &spec)
+{
+    static const pair<const char *, TraceCategory> names[] = {
+        {"cycle", TraceCategory::Cycle},
+        {"fetch", TraceCategory::Fetch},
+        {"decode", TraceCategory::Decode},
+        {"execute", TraceCategory::Execute},
+        {"mem", TraceCategory::Memory},
+        {"memory", TraceCategory::Memory},
+        {"writeback", TraceCategory::Writeback},
+        {"hazard", TraceCategory::Hazard},
+        {"stack", TraceCategory::Stack},
+        {"predictor", TraceCategory::Predictor},
+        {"cache", TraceCategory::Cache},
+    };
+
+    stringstream entries(spec);
+    string entry;
+    while (getline(entries, entry, ','))
+    {
+        if (entry.empty())
+        {
+            continue;
+        }
+
+        // Optional ":level" suffix
+        TraceLevel level = TraceLevel::Info;
+        size_t colon = entry.find(':');
+        if (colon != string::npos)
+        {
+            string levelName = entry.substr(colon + 1);
+            entry.resize(colon);
+            if (levelName == "debug")
+                level = TraceLevel::Debug;
+            else if (levelName == "info")
+                level = TraceLevel::Info;
+            else if (levelName == "off")
+                level = TraceLevel::Off;
+            else
+            {
+                cerr << "Error: unknown trace level '" << levelName << "'" << endl;
+                return false;
+            }
+        }
+
+        if (entry == "all")
+        {
+            traceSetAllLevels(level);
+            continue;
+        }
+
+        bool found = false;
+        for (const auto &name : names)
+        {
+            if (entry == name.first)
+            {
+                traceSetLevel(name.second, level);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            cerr << "Error: unknown trace category '" << entry << "'" << endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Areas of the simulator that can be traced independently
+enum class TraceCategory : uint8_t
+{
+    Cycle,     // Clock cycle banners and run-level messages
+    Fetch,
+    Decode,
+    Execute,
+    Memory,
+    Writeback,
+    Hazard,    // Stalls, forwarding and flushes
+    Stack,
+    Predictor,
+    Cache,
+    Count
+};
+
+// Verbosity of a category. A record is written when its level is at or
+// below the level enabled for its category.
+enum class TraceLevel : uint8_t
+{
+    Off = 0,
+    Info = 1,  // One line per stage per instruction
+    Debug = 2  // Idle stages, separators and other detail
+};
+
+// Largest number of arguments one record can carry
+constexpr size_t TRACE_MAX_ARGS = 6;
+
+// Fixed-size binary record. The format must be a string literal and %s
+// arguments must point to static strings; both are read later by the
+// formatter thread. Supported conversions: %d %u %x %X %s %c %%, with
+// optional 0 flag, width and l/ll length (64-bit %u/%x).
+struct TraceRecord
+{
+    const char *format;
+    uint32_t argCount;
+    uint64_t args[TRACE_MAX_ARGS];
+};
+
+// Enabled level per category; all Off by default
+extern uint8_t traceLevels[static_cast<size_t>(TraceCategory::Count)];
+
+inline bool traceEnabled(TraceCategory category, TraceLevel level)
+{
+    return __builtin_expect(traceLevels[static_cast<size_t>(category)] >= static_cast<uint8_t>(level), 0);
+}
+
+// Configuration
+void traceSetLevel(TraceCategory category, TraceLevel level);
+void traceSetAllLevels(TraceLevel level);
+
+// Parse a comma-separated list such as "fetch,hazard:debug" or "all".
+// Each entry enables a category (or all) at Info unless ":debug" or
+// ":info" follows. Prints an error and returns false on an unknown name.
+bool traceConfigure(const std::string &spec);
+
+// Destination of formatted output (stdout by default). Call before the
+// first record is written.
+void traceSetOutput(FILE *out);
+
+// Wait until every record written so far is formatted and flushed, so
+// that direct console output that follows appears after it
+void traceFlush();
+
+// Producer side of the ring. Records must come from one thread at a time.
+TraceRecord &traceReserve();
+void traceCommit();
+
+template <typename T>
+inline uint64_t traceArg(T value)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "unsupported trace argument");
+    if (std::is_signed<T>::value)
+    {
+        return static_cast<uint64_t>(static_cast<int64_t>(value));
+    }
+    return static_cast<uint64_t>(value);
+}
+
+inline uint64_t traceArg(const char *value)
+{
+    return reinterpret_cast<uintptr_t>(value);
+}
+
+template <typename... Args>
+inline void traceWrite(const char *format, Args... args)
+{
+    static_assert(sizeof...(Args) <= TRACE_MAX_ARGS, "too many trace arguments");
+    TraceRecord &record = traceReserve();
+    record.format = format;
+    record.argCount = sizeof...(Args);
+    const uint64_t values[] = {traceArg(args)..., 0};
+    std::memcpy(record.args, values, sizeof...(Args) * sizeof(uint64_t));
+    traceCommit();
+}
+
+// TRACE(Category, Level, "format", args...)
+// Building with -DRVSIM_NO_TRACE removes every call site; otherwise a
+// disabled category costs one load and one predictable branch.
+#ifdef RVSIM_NO_TRACE
+#define TRACE(category, level, ...)          \
+    do                                       \
+    {                                        \
+        if (false)                           \
+        {                                    \
+            traceWrite(__VA_ARGS__);         \
+        }                                    \
+    } while (0)
+#else
+#define TRACE(category, level, ...)                                          \
+    do                                                                       \
+    {                                                                        \
+        if (traceEnabled(TraceCategory::category, TraceLevel::level))        \
+        {                                                                    \
+            traceWrite(__VA_ARGS__);                                         \
+        }                                                                    \
+    } while (0)
+#endif
+
+// Horizontal rule printed between pipeline stages
+extern const char TRACE_SEPARATOR[];
+
+#endif // TRACE_H
@@ -1,161 +1,529 @@
-#include <bits/stdc++.h>
-#include "globals.h"
-#include "structs.h"
-using namespace std;
-
-void loadMC(const string &filename)
-{
-    ifstream file(filename);
-
-    if (!file.is_open())
-    {
-        cerr << "Error opening file: " << filename << endl;
-        return;
-    }
-
-    string line;
-    bool dataSegment = false;
-
-    while (getline(file, line))
-    {
-        // Check if we've reached the data segment marker
-        if (line.find("Data Segment") != string::npos)
-        {
-            dataSegment = true;
-            continue;
-        }
-
-        // Process based on whether we're in the instruction or data segment
-        if (!dataSegment)
-        {
-            // Skip empty lines or lines without commas (not instruction lines)
-            if (line.empty() || line.find(',') == string::npos)
-            {
-                continue;
-            }
-
-            size_t commaPos = line.find(',');
-
-            // Ensure the line has the expected format with PC and machine code separated by a comma
-            if (commaPos != string::npos)
-            {
-                string pc = line.substr(0, commaPos - 1);
-                pc = pc.substr(0, pc.find(' ')); // Remove trailing spaces
-
-                // Extract the machine code, removing leading/trailing spaces
-                string machine_code = line.substr(commaPos + 2);
-                size_t startPos = machine_code.find_first_not_of(' ');
-                if (startPos != string::npos)
-                {
-                    machine_code = machine_code.substr(startPos);
-                }
-
-                size_t endPos = machine_code.find(' ');
-                if (endPos != string::npos)
-                {
-                    machine_code = machine_code.substr(0, endPos);
-                }
-
-                pcMachineCode[pc] = machine_code;
-            }
-        }
-        else
-        {
-            // Process data segment lines
-            // Skip empty lines or marker lines
-            if (line.empty() || line.find("****") != string::npos)
-            {
-                continue;
-            }
-
-            // Parse data memory line like: "0x10000000   61 62 63 64"
-            stringstream ss(line);
-            string addrStr;
-            ss >> addrStr; // Read address
-
-            if (addrStr.empty() || addrStr[0] != '0')
-            {
-                continue; // Skip invalid lines
-            }
-
-            // Convert hex address to integer
-            unsigned int baseAddr;
-            try
-            {
-                baseAddr = stoul(addrStr, nullptr, 16);
-            }
-            catch (...)
-            {
-                continue; // Skip if address conversion fails
-            }
-
-            // Read byte values
-            string byteStr;
-            unsigned int offset = 0;
-
-            while (ss >> byteStr)
-            {
-                // Convert hex byte to integer
-                try
-                {
-                    unsigned char byteVal = stoul(byteStr, nullptr, 16);
-                    dataMemory[baseAddr + offset] = byteVal;
-                    offset++;
-                }
-                catch (...)
-                {
-                    // Skip if byte conversion fails
-                }
-            }
-        }
-    }
-
-    file.close();
-    cout << "Loaded " << pcMachineCode.size() << " instructions and "
-         << dataMemory.size() << " bytes of data memory." << endl;
-}
-
-string hex2bin(string hexStr)
-{
-    // Check for "0x" prefix and remove it
-    if (hexStr.substr(0, 2) == "0x" || hexStr.substr(0, 2) == "0X")
-    {
-        hexStr = hexStr.substr(2); // Remove "0x"
-    }
-
-    // Ensure valid length (8 characters for 32 bits)
-    if (hexStr.length() > 8)
-    {
-        cout << "Invalid instruction. Please enter exactly 8 hexadecimal digits." << endl;
-        return "";
-    }
-
-    // Convert hex string to unsigned int
-    unsigned int num;
-    stringstream ss;
-    ss << hex << hexStr;
-    ss >> num;
-
-    // Convert to 32-bit binary representation
-    bitset<32> binary(num);
-    return binary.to_string();
-}
-
-string bin2hex(string binStr)
-{
-    // Ensure valid length (32 characters for 32 bits)
-    if (binStr.length() > 32)
-    {
-        cout << "Invalid input. Please enter exactly 32 binary digits." << endl;
-        return "";
-    }
-
-    // Convert binary string to unsigned int
-    bitset<32> binary(binStr);
-    unsigned int num = binary.to_ulong();
-
-    // Convert to hex string
-    stringstream ss;
-    ss << hex << num;
-    return ss.str();
-}
+#include <bits/stdc++.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <elf.h>
+#include "globals.h"
+#include "structs.h"
+#include "utils.h"
+#include "elfLoader.h"
+#include "assembler.h"
+#include "trace.h"
+using namespace std;
+
+__constinit thread_local LoadInfo lastLoad;
+
+// Files above this size are parsed by several threads
+static constexpr size_t PARALLEL_THRESHOLD = 4 << 20;
+
+// Target size of one parallel chunk; cut at the next line break
+static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+// Value of each ASCII hex digit, 0xFF for every other byte
+static constexpr array<uint8_t, 256> HEX_VALUE = []
+{
+    array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; c++)
+    {
+        table[c] = 0xFF;
+    }
+    for (int c = '0'; c <= '9'; c++)
+    {
+        table[c] = c - '0';
+    }
+    for (int c = 'a'; c <= 'f'; c++)
+    {
+        table[c] = c - 'a' + 10;
+        table[c - 'a' + 'A'] = c - 'a' + 10;
+    }
+    return table;
+}();
+
+static inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Eight hex digits at p as one word, or false if any of them is not a hex
+// digit. The digits are checked with independent table lookups and then
+// converted four bits per byte in parallel (SWAR), without a loop.
+static inline bool parseHex8(const char *p, uint32_t &value)
+{
+    uint8_t check = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        check |= HEX_VALUE[static_cast<uint8_t>(p[i])];
+    }
+    if (check > 0x0F)
+    {
+        return false;
+    }
+
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    // '0'-'9' keep their low nibble; letters have bit 6 set and need 9 more
+    x = (x & 0x0F0F0F0F0F0F0F0FULL) + 9 * ((x >> 6) & 0x0101010101010101ULL);
+    // The first digit is in the lowest byte; fold neighbours together
+    x = ((x & 0x000F000F000F000FULL) << 4) | ((x >> 8) & 0x000F000F000F000FULL);
+    x = ((x & 0x000000FF000000FFULL) << 8) | ((x >> 16) & 0x000000FF000000FFULL);
+    x = ((x & 0x000000000000FFFFULL) << 16) | ((x >> 32) & 0x000000000000FFFFULL);
+    value = static_cast<uint32_t>(x);
+    return true;
+}
+
+// Hex number at p with an optional 0x prefix. Advances p past the digits
+// and returns false if there are none. Only the low 32 bits are kept.
+static inline bool parseHex(const char *&p, const char *end, uint32_t &value)
+{
+    if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') &&
+        end - p >= 3 && HEX_VALUE[static_cast<uint8_t>(p[2])] <= 0x0F)
+    {
+        p += 2;
+    }
+
+    // Common case: exactly eight digits, as the assembler writes them
+    if (end - p >= 9 && HEX_VALUE[static_cast<uint8_t>(p[8])] > 0x0F && parseHex8(p, value))
+    {
+        p += 8;
+        return true;
+    }
+
+    const char *start = p;
+    uint32_t result = 0;
+    while (p < end)
+    {
+        uint8_t digit = HEX_VALUE[static_cast<uint8_t>(*p)];
+        if (digit > 0x0F)
+        {
+            break;
+        }
+        result = (result << 4) | digit;
+        p++;
+    }
+    value = result;
+    return p != start;
+}
+
+// Parsed contents of one slice of the file, kept aside when the slice is
+// parsed off the loading thread (simulator state is thread_local)
+struct ParsedChunk
+{
+    struct DataRun
+    {
+        uint32_t address;
+        size_t offset; // Into bytes
+        size_t length;
+    };
+
+    struct FillRun
+    {
+        uint32_t address;
+        uint32_t length;
+        uint8_t value;
+    };
+
+    vector<pair<uint32_t, uint32_t>> text; // (pc, machine code)
+    vector<DataRun> runs;
+    vector<uint8_t> bytes;
+    vector<FillRun> fills;
+};
+
+// Parse the lines in [p, end). Text lines look like
+//     0x4 , 0x001005B7 lui x11 0x100 # ...
+// and lines without a comma are skipped. Data lines look like
+//     0x10000000   01 00 00 00
+// and must start with '0'. A data line may instead hold one filled run,
+//     0x10000040   00*1000
+// which is a byte and a hex count (here 4096 zero bytes). Tokens that are
+// not hex are skipped. Parsed words go to text; each data line is passed
+// to store(address, bytes, n) and each run to fill(address, value, n).
+template <typename Store, typename Fill>
+static void parseLines(const char *p, const char *end, bool dataSegment,
+                       vector<pair<uint32_t, uint32_t>> &text, Store store, Fill fill)
+{
+    uint8_t lineBytes[256];
+
+    while (p < end)
+    {
+        const char *lineEnd = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+        const char *q = p;
+        p = lineEnd + 1;
+
+        if (!dataSegment)
+        {
+            const char *comma = static_cast<const char *>(memchr(q, ',', lineEnd - q));
+            uint32_t pc, word;
+            if (comma == nullptr || !parseHex(q, comma, pc))
+            {
+                continue;
+            }
+            q = comma + 1;
+            while (q < lineEnd && isBlank(*q))
+            {
+                q++;
+            }
+            if (parseHex(q, lineEnd, word))
+            {
+                text.emplace_back(pc, word);
+            }
+            continue;
+        }
+
+        // Data line: address, then one byte per token
+        while (q < lineEnd && isBlank(*q))
+        {
+            q++;
+        }
+        uint32_t address;
+        if (q == lineEnd || *q != '0' || !parseHex(q, lineEnd, address))
+        {
+            continue;
+        }
+        while (q < lineEnd && !isBlank(*q))
+        {
+            q++;
+        }
+
+        size_t count = 0;
+        uint32_t runStart = address;
+        while (true)
+        {
+            while (q < lineEnd && isBlank(*q))
+            {
+                q++;
+            }
+            if (q == lineEnd)
+            {
+                break;
+            }
+            uint32_t value, length;
+            if (parseHex(q, lineEnd, value))
+            {
+                if (q < lineEnd && *q == '*')
+                {
+                    q++;
+                    if (parseHex(q, lineEnd, length))
+                    {
+                        fill(runStart + count, static_cast<uint8_t>(value), length);
+                    }
+                    break;
+                }
+                lineBytes[count++] = static_cast<uint8_t>(value);
+                if (count == sizeof(lineBytes))
+                {
+                    store(runStart, lineBytes, count);
+                    runStart += count;
+                    count = 0;
+                }
+            }
+            while (q < lineEnd && !isBlank(*q))
+            {
+                q++;
+            }
+        }
+        if (count > 0)
+        {
+            store(runStart, lineBytes, count);
+        }
+    }
+}
+
+// Split [begin, end) at line breaks into pieces of about CHUNK_SIZE, parse
+// them on several threads, then apply the results in file order. Returns
+// the number of data bytes stored.
+static size_t parseParallel(const char *begin, const char *end, bool dataSegment,
+                            vector<pair<uint32_t, uint32_t>> &text)
+{
+    vector<pair<const char *, const char *>> pieces;
+    for (const char *p = begin; p < end;)
+    {
+        const char *cut = p + min<size_t>(CHUNK_SIZE, end - p);
+        if (cut < end)
+        {
+            const char *newline = static_cast<const char *>(memchr(cut, '\n', end - cut));
+            cut = (newline != nullptr) ? newline + 1 : end;
+        }
+        pieces.emplace_back(p, cut);
+        p = cut;
+    }
+
+    vector<ParsedChunk> chunks(pieces.size());
+    unsigned threads = static_cast<unsigned>(min<size_t>(max(1u, thread::hardware_concurrency()), pieces.size()));
+    atomic<size_t> nextPiece{0};
+    auto worker = [&]()
+    {
+        for (size_t i = nextPiece++; i < pieces.size(); i = nextPiece++)
+        {
+            ParsedChunk &chunk = chunks[i];
+            parseLines(pieces[i].first, pieces[i].second, dataSegment, chunk.text,
+                       [&chunk](uint32_t address, const uint8_t *bytes, size_t length)
+                       {
+                           chunk.runs.push_back({address, chunk.bytes.size(), length});
+                           chunk.bytes.insert(chunk.bytes.end(), bytes, bytes + length);
+                       },
+                       [&chunk](uint32_t address, uint8_t value, uint32_t length)
+                       {
+                           chunk.fills.push_back({address, length, value});
+                       });
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned t = 1; t < threads; t++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (thread &t : workers)
+    {
+        t.join();
+    }
+
+    size_t dataBytes = 0;
+    for (const ParsedChunk &chunk : chunks)
+    {
+        dataBytes += chunk.bytes.size();
+        text.insert(text.end(), chunk.text.begin(), chunk.text.end());
+        for (const ParsedChunk::DataRun &run : chunk.runs)
+        {
+            dataMemory.writeBytes(run.address, chunk.bytes.data() + run.offset, run.length);
+        }
+        for (const ParsedChunk::FillRun &run : chunk.fills)
+        {
+            dataMemory.fill(run.address, run.value, run.length);
+            dataBytes += run.length;
+        }
+    }
+    return dataBytes;
+}
+
+// Parse one segment of the file; returns the number of data bytes stored
+static size_t parseRegion(const char *begin, const char *end, bool dataSegment,
+                          vector<pair<uint32_t, uint32_t>> &text)
+{
+    if (static_cast<size_t>(end - begin) > PARALLEL_THRESHOLD)
+    {
+        return parseParallel(begin, end, dataSegment, text);
+    }
+
+    size_t dataBytes = 0;
+    parseLines(begin, end, dataSegment, text,
+               [&dataBytes](uint32_t address, const uint8_t *bytes, size_t length)
+               {
+                   dataMemory.writeBytes(address, bytes, length);
+                   dataBytes += length;
+               },
+               [&dataBytes](uint32_t address, uint8_t value, uint32_t length)
+               {
+                   dataMemory.fill(address, value, length);
+                   dataBytes += length;
+               });
+    return dataBytes;
+}
+
+// Assemble a source file in memory and load the result the way its
+// output.mc would be loaded. Symbols are kept for reporting.
+static bool loadAssembly(const char *contents, size_t size, const string &filename)
+{
+    AssemblerOptions options;
+    options.sourceName = filename;
+    ProgramImage program = assemble(string_view(contents, size), options);
+    if (!program.ok())
+    {
+        cerr << program.errors << "Error loading " << filename << ": the program has errors" << endl;
+        return false;
+    }
+
+    textSegment = move(program.text);
+    textBase = 0;
+    textData = textSegment.data();
+    textWordCount = textSegment.size();
+    entryPC = textBase; // As output.mc: the text starts at main, or jumps there
+
+    uint64_t dataBytes = 0;
+    program.data.forEachRun(
+        [&dataBytes](LongInt offset, const uint8_t *bytes, LongInt length)
+        {
+            dataMemory.writeBytes(DATA_BASE + offset, bytes, length);
+            dataBytes += length;
+        },
+        [&dataBytes](LongInt offset, uint8_t value, LongInt length)
+        {
+            dataMemory.fill(DATA_BASE + offset, value, length);
+            dataBytes += length;
+        });
+
+    programSymbols.clear();
+    for (const auto &symbol : program.symbols)
+    {
+        programSymbols.push_back({static_cast<uint32_t>(symbol.second), 0, symbol.first});
+    }
+
+    lastLoad.instructions = textWordCount;
+    lastLoad.dataBytes = dataBytes;
+    TRACE(Cycle, Info, "Assembled %u instructions and %llu bytes of data memory.\n",
+          textWordCount, dataBytes);
+    return true;
+}
+
+bool loadMC(const string &filename)
+{
+    auto start = chrono::steady_clock::now();
+
+    // Map the whole file; fall back to reading it for pipes and the like
+    const char *contents = nullptr;
+    size_t size = 0;
+    void *mapping = MAP_FAILED;
+    string buffer;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        cerr << "Error opening file: " << filename << endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        size = static_cast<size_t>(info.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (mapping != MAP_FAILED)
+    {
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        contents = static_cast<const char *>(mapping);
+    }
+    else
+    {
+        ifstream file(filename, ios::binary);
+        buffer.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        contents = buffer.data();
+        size = buffer.size();
+    }
+    close(fd);
+
+    // Executables are recognised by their magic number, sources by name
+    bool elf = size >= SELFMAG && memcmp(contents, ELFMAG, SELFMAG) == 0;
+    bool assembly = filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".asm") == 0;
+    if (elf || assembly)
+    {
+        bool loaded = elf ? loadELF(contents, size, filename) : loadAssembly(contents, size, filename);
+        if (mapping != MAP_FAILED)
+        {
+            munmap(mapping, size);
+        }
+        lastLoad.fileBytes = size;
+        lastLoad.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return loaded;
+    }
+
+    // Everything after the line holding the marker is data
+    static const char MARKER[] = "Data Segment";
+    const char *end = contents + size;
+    const char *marker = static_cast<const char *>(memmem(contents, size, MARKER, sizeof(MARKER) - 1));
+    const char *textEnd = end, *dataBegin = end;
+    if (marker != nullptr)
+    {
+        const char *lineStart = marker;
+        while (lineStart > contents && lineStart[-1] != '\n')
+        {
+            lineStart--;
+        }
+        const char *lineEnd = static_cast<const char *>(memchr(marker, '\n', end - marker));
+        textEnd = lineStart;
+        dataBegin = (lineEnd != nullptr) ? lineEnd + 1 : end;
+    }
+
+    vector<pair<uint32_t, uint32_t>> textWords; // (pc, machine code) as listed
+    size_t dataBytes = parseRegion(contents, textEnd, false, textWords);
+    dataBytes += parseRegion(dataBegin, end, true, textWords);
+
+    if (mapping != MAP_FAILED)
+    {
+        munmap(mapping, size);
+    }
+
+    // Lay the listed words out as a dense image starting at the lowest PC
+    textSegment.clear();
+    textBase = 0;
+    if (!textWords.empty())
+    {
+        uint32_t lowPC = textWords[0].first, highPC = textWords[0].first;
+        for (const auto &entry : textWords)
+        {
+            lowPC = min(lowPC, entry.first);
+            highPC = max(highPC, entry.first);
+        }
+        textBase = lowPC & ~3u;
+        textSegment.assign(((highPC - textBase) >> 2) + 1, 0);
+        for (const auto &entry : textWords)
+        {
+            textSegment[(entry.first - textBase) >> 2] = entry.second;
+        }
+    }
+    textData = textSegment.data();
+    textWordCount = textSegment.size();
+    entryPC = textBase;
+    programSymbols.clear();
+
+    lastLoad.fileBytes = size;
+    lastLoad.instructions = textWords.size();
+    lastLoad.dataBytes = dataBytes;
+    lastLoad.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    TRACE(Cycle, Info, "Loaded %u instructions and %u bytes of data memory.\n",
+          textWords.size(), dataBytes);
+    TRACE(Cycle, Debug, "Parsed %llu bytes in %llu us.\n", lastLoad.fileBytes,
+          static_cast<uint64_t>(lastLoad.seconds * 1e6));
+    return true;
+}
+
+string hex2bin(string hexStr)
+{
+    // Check for "0x" prefix and remove it
+    if (hexStr.substr(0, 2) == "0x" || hexStr.substr(0, 2) == "0X")
+    {
+        hexStr = hexStr.substr(2); // Remove "0x"
+    }
+
+    // Ensure valid length (8 characters for 32 bits)
+    if (hexStr.length() > 8)
+    {
+        cout << "Invalid instruction. Please enter exactly 8 hexadecimal digits." << endl;
+        return "";
+    }
+
+    // Convert hex string to unsigned int
+    unsigned int num;
+    stringstream ss;
+    ss << hex << hexStr;
+    ss >> num;
+
+    // Convert to 32-bit binary representation
+    bitset<32> binary(num);
+    return binary.to_string();
+}
+
+string bin2hex(string binStr)
+{
+    // Ensure valid length (32 characters for 32 bits)
+    if (binStr.length() > 32)
+    {
+        cout << "Invalid input. Please enter exactly 32 binary digits." << endl;
+        return "";
+    }
+
+    // Convert binary string to unsigned int
+    bitset<32> binary(binStr);
+    unsigned int num = binary.to_ulong();
+
+    // Convert to hex string
+    stringstream ss;
+    ss << hex << num;
+    return ss.str();
+}
@@ -1,11 +1,27 @@
-#ifndef UTILS_H
-#define UTILS_H
-
-#include <string>
-
-// Utility functions
-void loadMC(const std::string &filename);
-std::string hex2bin(std::string hexStr);
-std::string bin2hex(std::string binStr);
-
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Size and timing of the last loadMC() on this thread
+struct LoadInfo
+{
+    uint64_t fileBytes = 0;
+    uint64_t instructions = 0;
+    uint64_t dataBytes = 0;
+    double seconds = 0;
+};
+extern __constinit thread_local LoadInfo lastLoad;
+
+// Utility functions
+// Load a .mc file, an ELF32 executable (see elfLoader.h) or a .asm source,
+// which is assembled in memory, into the program image and data memory;
+// false if unreadable. The file is memory-mapped and large .mc files are
+// parsed by several threads.
+bool loadMC(const std::string &filename);
+std::string hex2bin(std::string hexStr);
+std::string bin2hex(std::string binStr);
+
 #endif // UTILS_H
\ No newline at end of file